@@ -0,0 +1,407 @@
+#include <lttng/ctf.h>
+#include <lttng/event_view.h>
+#include <lttng/generator.h>
+#include <lttng/lttng.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Every allocation in this process is counted, such that we can report
+// allocations per event for the individual benchmark cases.
+std::atomic<std::uint64_t> allocations{0};
+// Results of the individual cases are written here, such that the compiler cannot discard them.
+volatile std::uint64_t sink{0};
+}
+
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (auto p = std::malloc(size == 0 ? 1 : size))
+    return p;
+
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+// Options configures a run of the benchmark suite, parsed from --key=value pairs.
+struct Options
+{
+  ctf::generator::Shape shape = ctf::generator::default_shape();
+  boost::filesystem::path trace; // Benchmark an existing trace instead of generating one.
+  boost::filesystem::path output; // Write results to this file instead of stdout.
+  unsigned int repetitions{3};
+};
+
+Options parse_options(int argc, char** argv)
+{
+  Options options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg{argv[i]};
+    auto pos = arg.find('=');
+
+    if (arg.compare(0, 2, "--") != 0 || pos == std::string::npos)
+      throw std::runtime_error("Expected --key=value, got: " + arg);
+
+    auto key = arg.substr(2, pos - 2);
+    auto value = arg.substr(pos + 1);
+
+    if (key == "events")
+      options.shape.events = boost::lexical_cast<std::uint64_t>(value);
+    else if (key == "bytes")
+      options.shape.bytes = boost::lexical_cast<std::uint64_t>(value);
+    else if (key == "streams")
+      options.shape.streams = boost::lexical_cast<std::uint32_t>(value);
+    else if (key == "packet-size")
+      options.shape.packet_size = boost::lexical_cast<std::uint32_t>(value);
+    else if (key == "processes")
+      options.shape.processes = boost::lexical_cast<std::uint32_t>(value);
+    else if (key == "mix")
+      options.shape.mix = boost::lexical_cast<ctf::generator::Mix>(value);
+    else if (key == "trace")
+      options.trace = value;
+    else if (key == "output")
+      options.output = value;
+    else if (key == "repetitions")
+      options.repetitions = boost::lexical_cast<unsigned int>(value);
+    else
+      throw std::runtime_error("Unknown option: " + key);
+  }
+
+  return options;
+}
+
+// Resets the peak resident set size of this process to its current resident set size,
+// such that peak_rss_kib reports the peak of the code running afterwards. Requires Linux 4.0.
+void reset_peak_rss()
+{
+  std::ofstream clear_refs{"/proc/self/clear_refs"};
+  clear_refs << "5" << std::flush;
+}
+
+// Returns the peak resident set size of this process since the last reset_peak_rss, in KiB.
+// Falls back to the peak over the lifetime of the process if /proc is not available.
+long peak_rss_kib()
+{
+  std::ifstream status{"/proc/self/status"};
+  std::string line;
+
+  while (std::getline(status, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::strtol(line.c_str() + 6, nullptr, 10);
+
+  rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Returns the given string as a quoted JSON string, escaping as necessary.
+std::string json_string(const std::string& s)
+{
+  std::string result{"\""};
+
+  for (auto c : s)
+  {
+    switch (c)
+    {
+      case '"': result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      case '\t': result += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+          result += escaped;
+        }
+        else
+        {
+          result += c;
+        }
+    }
+  }
+
+  return result + "\"";
+}
+
+// Returns the number of bytes of all files in the given directory, recursively.
+std::uint64_t size_of(const boost::filesystem::path& path)
+{
+  std::uint64_t result{0};
+
+  for (boost::filesystem::recursive_directory_iterator it(path), itE; it != itE; ++it)
+    if (boost::filesystem::is_regular_file(*it))
+      result += boost::filesystem::file_size(*it);
+
+  return result;
+}
+
+// NullBuffer swallows all characters written to it, without short-circuiting formatting.
+class NullBuffer : public std::streambuf
+{
+ protected:
+  int overflow(int c) override
+  {
+    return c;
+  }
+
+  std::streamsize xsputn(const char*, std::streamsize n) override
+  {
+    return n;
+  }
+};
+
+// Case is an individual benchmark, walking a trace once and returning the number of events it has seen.
+struct Case
+{
+  std::string name;
+  std::function<std::uint64_t(ctf::Trace&)> run;
+};
+
+std::vector<Case> cases()
+{
+  return
+  {
+    {
+      "full_decode",
+      [](ctf::Trace& trace)
+      {
+        std::uint64_t events{0};
+        trace.for_each_event([&events](const ctf::Event&)
+        {
+          events++;
+          return ctf::Trace::EventEnumeratorReply::ok;
+        });
+        return events;
+      }
+    },
+    {
+      "name_only",
+      [](ctf::Trace& trace)
+      {
+        std::uint64_t events{0}, mallocs{0};
+        trace.for_each_event([&events, &mallocs](const ctf::Event& event)
+        {
+          events++;
+          if (event.name == lttng::events::userspace::libc::malloc)
+            mallocs++;
+          return ctf::Trace::EventEnumeratorReply::ok;
+        });
+        sink = mallocs;
+        return events;
+      }
+    },
+    {
+      "field_spec",
+      [](ctf::Trace& trace)
+      {
+        ctf::FieldSpec<ctf::Field::Type::integer> size{ctf::Scope::event_fields, "size"};
+        ctf::FieldSpec<ctf::Field::Type::integer> vpid{ctf::Scope::stream_event_context, "vpid"};
+
+        std::uint64_t events{0}, sum{0};
+        trace.for_each_event([&](const ctf::Event& event)
+        {
+          events++;
+          if (size.available_in(event))
+            sum += size.interpret(event)->as_uint64();
+          if (vpid.available_in(event))
+            sum += vpid.interpret(event)->as_int64();
+          return ctf::Trace::EventEnumeratorReply::ok;
+        });
+        sink = sum;
+        return events;
+      }
+    },
+    {
+      "event_view",
+      [](ctf::Trace& trace)
+      {
+        ctf::EventView
+        <
+          ctf::view::Field<ctf::Scope::event_fields, std::uint64_t>,
+          ctf::view::Field<ctf::Scope::stream_event_context, std::int64_t>
+        > malloc{lttng::events::userspace::libc::malloc, {{"size", "vpid"}}};
+
+        std::uint64_t events{0}, sum{0};
+        decltype(malloc)::Values values;
+
+        trace.for_each_raw_event([&](const bt_ctf_event* event)
+        {
+          events++;
+          if (malloc.extract(event, values))
+            sum += std::get<0>(values) + std::get<1>(values);
+          return ctf::Trace::EventEnumeratorReply::ok;
+        });
+        sink = sum;
+        return events;
+      }
+    },
+    {
+      "print",
+      [](ctf::Trace& trace)
+      {
+        NullBuffer buffer; std::ostream out{&buffer};
+
+        std::uint64_t events{0};
+        trace.for_each_event([&](const ctf::Event& event)
+        {
+          events++;
+          out << event << "\n";
+          return ctf::Trace::EventEnumeratorReply::ok;
+        });
+        return events;
+      }
+    }
+  };
+}
+
+// Result summarizes the repetitions of a single case.
+struct Result
+{
+  std::string name;
+  unsigned int repetitions;
+  std::uint64_t events;
+  double seconds;
+  std::uint64_t allocations;
+  long peak_rss_kib;
+};
+
+Result measure(const Case& c, const boost::filesystem::path& path, unsigned int repetitions)
+{
+  Result result{c.name, repetitions, 0, 0., 0, 0};
+
+  reset_peak_rss();
+
+  for (unsigned int i = 0; i < repetitions; i++)
+  {
+    ctf::Trace trace{path};
+
+    auto allocations_before = allocations.load();
+    auto before = std::chrono::steady_clock::now();
+
+    result.events += c.run(trace);
+
+    auto after = std::chrono::steady_clock::now();
+    result.allocations += allocations.load() - allocations_before;
+    result.seconds += std::chrono::duration<double>(after - before).count();
+  }
+
+  result.peak_rss_kib = peak_rss_kib();
+  return result;
+}
+
+void print_json(std::ostream& out, const Options& options, const boost::filesystem::path& path, std::uint64_t bytes, const std::vector<Result>& results)
+{
+  out << "{\n"
+      << "  \"trace\": {\n"
+      << "    \"path\": " << json_string(path.string()) << ",\n"
+      << "    \"bytes\": " << bytes;
+
+  if (options.trace.empty())
+    out << ",\n"
+        << "    \"shape\": {\n"
+        << "      \"events\": " << options.shape.events << ",\n"
+        << "      \"bytes\": " << options.shape.bytes << ",\n"
+        << "      \"streams\": " << options.shape.streams << ",\n"
+        << "      \"packet_size\": " << options.shape.packet_size << ",\n"
+        << "      \"processes\": " << options.shape.processes << ",\n"
+        << "      \"mix\": " << json_string(boost::lexical_cast<std::string>(options.shape.mix)) << "\n"
+        << "    }";
+
+  out << "\n"
+      << "  },\n"
+      << "  \"results\": [\n";
+
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const auto& r = results[i];
+    double events = r.events ? r.events : 1;
+
+    out << "    {\n"
+        << "      \"name\": " << json_string(r.name) << ",\n"
+        << "      \"repetitions\": " << r.repetitions << ",\n"
+        << "      \"events\": " << r.events << ",\n"
+        << "      \"seconds\": " << r.seconds << ",\n"
+        << "      \"events_per_second\": " << r.events / r.seconds << ",\n"
+        << "      \"bytes_per_second\": " << bytes * r.repetitions / r.seconds << ",\n"
+        << "      \"allocations_per_event\": " << r.allocations / events << ",\n"
+        << "      \"peak_rss_kib\": " << r.peak_rss_kib << "\n"
+        << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+
+  out << "  ]\n"
+      << "}" << std::endl;
+}
+}
+
+// Call like: ./lttng-benchmarks --events=1000000 --streams=4 --mix=mixed --output=results.json
+int main(int argc, char** argv)
+{
+  try
+  {
+    auto options = parse_options(argc, argv);
+    auto path = options.trace;
+
+    if (path.empty())
+    {
+      path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-benchmarks-%%%%-%%%%");
+      ctf::generator::generate(path, options.shape);
+    }
+
+    auto bytes = size_of(path);
+
+    std::vector<Result> results;
+    for (const auto& c : cases())
+      results.push_back(measure(c, path, options.repetitions));
+
+    if (options.trace.empty())
+      boost::filesystem::remove_all(path);
+
+    if (options.output.empty())
+    {
+      print_json(std::cout, options, path, bytes, results);
+    }
+    else
+    {
+      boost::filesystem::ofstream out{options.output};
+      print_json(out, options, path, bytes, results);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,386 @@
+#include <lttng/ctf.h>
+#include <lttng/lttng.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+// Calling malloc through a volatile pointer keeps the compiler from eliding malloc/free pairs.
+void* (*volatile allocate)(std::size_t) = std::malloc;
+
+// Options configures a run of the overhead benchmarks, parsed from --key=value pairs.
+struct Options
+{
+  std::string workload{"all"}; // malloc, mutex or all.
+  std::uint64_t iterations{100000}; // Iterations per thread.
+  unsigned int threads{4};
+  unsigned int repetitions{3};
+  boost::filesystem::path directory{boost::filesystem::temp_directory_path()}; // Traces are recorded below this directory.
+  boost::filesystem::path output; // Write results to this file instead of stdout.
+};
+
+Options parse_options(int argc, char** argv)
+{
+  Options options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg{argv[i]};
+    auto pos = arg.find('=');
+
+    if (arg.compare(0, 2, "--") != 0 || pos == std::string::npos)
+      throw std::runtime_error("Expected --key=value, got: " + arg);
+
+    auto key = arg.substr(2, pos - 2);
+    auto value = arg.substr(pos + 1);
+
+    if (key == "workload")
+      options.workload = value;
+    else if (key == "iterations")
+      options.iterations = boost::lexical_cast<std::uint64_t>(value);
+    else if (key == "threads")
+      options.threads = boost::lexical_cast<unsigned int>(value);
+    else if (key == "repetitions")
+      options.repetitions = boost::lexical_cast<unsigned int>(value);
+    else if (key == "directory")
+      options.directory = value;
+    else if (key == "output")
+      options.output = value;
+    else
+      throw std::runtime_error("Unknown option: " + key);
+  }
+
+  return options;
+}
+
+// Workload is a reproducible load, instrumented by one of lttng's LD_PRELOAD wrappers.
+struct Workload
+{
+  std::string name;
+  std::string events; // The events emitted by the workload, enabled in every traced run.
+  std::function<void(unsigned int thread, std::uint64_t iterations)> run; // Runs the iterations of a single thread.
+};
+
+std::vector<Workload> workloads()
+{
+  static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+  return
+  {
+    {
+      "malloc",
+      lttng::events::userspace::libc::all,
+      [](unsigned int thread, std::uint64_t iterations)
+      {
+        // Every thread draws the same sequence of sizes in every run.
+        std::default_random_engine rng{thread};
+        std::uniform_int_distribution<std::size_t> dist(1, 500);
+
+        for (std::uint64_t i = 0; i < iterations; i++)
+          std::free(allocate(dist(rng)));
+      }
+    },
+    {
+      "mutex",
+      lttng::events::userspace::pthread::all,
+      [](unsigned int, std::uint64_t iterations)
+      {
+        for (std::uint64_t i = 0; i < iterations; i++)
+        {
+          pthread_mutex_lock(&mutex);
+          pthread_mutex_unlock(&mutex);
+        }
+      }
+    }
+  };
+}
+
+// Returns the wall-clock time it takes options.threads threads to run the given workload.
+std::chrono::nanoseconds run_timed(const Workload& workload, const Options& options)
+{
+  std::atomic<bool> go{false};
+  std::atomic<unsigned int> ready{0};
+  std::vector<std::thread> threads;
+
+  for (unsigned int i = 0; i < options.threads; i++)
+    threads.emplace_back([&, i]()
+    {
+      ready++;
+      while (not go)
+        std::this_thread::yield();
+
+      workload.run(i, options.iterations);
+    });
+
+  while (ready != options.threads)
+    std::this_thread::yield();
+
+  auto before = std::chrono::steady_clock::now();
+  go = true;
+
+  for (auto& thread : threads)
+    thread.join();
+
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before);
+}
+
+// Configuration is a session setup the workloads are measured under.
+struct Configuration
+{
+  std::string name;
+  std::vector<lttng::Context> contexts;
+  std::function<lttng::Channel()> channel;
+};
+
+// Returns the cross product of context sets and channel settings.
+std::vector<Configuration> configurations()
+{
+  std::vector<std::pair<std::string, std::vector<lttng::Context>>> contexts
+  {
+    {"no-context", {}},
+    {"vtid", {lttng::Context::vtid}},
+    {"vpid-vtid-procname", {lttng::Context::vpid, lttng::Context::vtid, lttng::Context::proc_name}},
+    {"vpid-vtid-procname-ip", {lttng::Context::vpid, lttng::Context::vtid, lttng::Context::proc_name, lttng::Context::ip}}
+  };
+
+  std::vector<std::pair<std::string, std::function<lttng::Channel()>>> channels
+  {
+    {"default", []() { return lttng::Channel::defaults(lttng::Domain::userspace, "overhead"); }},
+    {
+      "small-discard", []()
+      {
+        auto channel = lttng::Channel::defaults(lttng::Domain::userspace, "overhead");
+        channel.subbuffer_size = 4096;
+        channel.subbuffer_count = 2;
+        return channel;
+      }
+    },
+    {
+      "overwrite", []()
+      {
+        auto channel = lttng::Channel::defaults(lttng::Domain::userspace, "overhead");
+        channel.mode = lttng::Channel::Mode::overwrite;
+        return channel;
+      }
+    },
+    {
+      "large", []()
+      {
+        auto channel = lttng::Channel::defaults(lttng::Domain::userspace, "overhead");
+        channel.subbuffer_size = 4 * 1024 * 1024;
+        channel.subbuffer_count = 8;
+        return channel;
+      }
+    }
+  };
+
+  std::vector<Configuration> result;
+  for (const auto& context : contexts)
+    for (const auto& channel : channels)
+      result.push_back(Configuration{context.first + "/" + channel.first, context.second, channel.second});
+
+  return result;
+}
+
+// Events counts the events recorded to a trace, and the ones the tracer reported as discarded.
+struct Events
+{
+  std::uint64_t recorded;
+  std::uint64_t discarded;
+};
+
+Events count(const boost::filesystem::path& path)
+{
+  Events result{0, 0};
+
+  // events_discarded in the packet context counts all events a stream has discarded
+  // so far. Streams are identified by their (stream_id, cpu_id) pair.
+  std::map<std::tuple<std::uint64_t, std::uint64_t>, std::uint64_t> discarded;
+
+  // Reads the unsigned integer field with the given name from the given scope, 0 if not present.
+  auto read = [](const bt_ctf_event* event, const bt_definition* scope, const char* name) -> std::uint64_t
+  {
+    auto field = scope ? bt_ctf_get_field(event, scope, name) : nullptr;
+    return field ? bt_ctf_get_uint64(field) : 0;
+  };
+
+  ctf::Trace trace{path};
+  trace.for_each_raw_event([&](const bt_ctf_event* event)
+  {
+    result.recorded++;
+
+    auto header = bt_ctf_get_top_level_scope(event, BT_TRACE_PACKET_HEADER);
+    auto packet_context = bt_ctf_get_top_level_scope(event, BT_STREAM_PACKET_CONTEXT);
+    auto& stream = discarded[std::make_tuple(read(event, header, "stream_id"), read(event, packet_context, "cpu_id"))];
+
+    stream = std::max(stream, read(event, packet_context, "events_discarded"));
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ctf::Ordering::none);
+
+  for (const auto& pair : discarded)
+    result.discarded += pair.second;
+
+  return result;
+}
+
+// Result summarizes the repetitions of a workload under a single configuration.
+struct Result
+{
+  std::string name;
+  std::chrono::nanoseconds elapsed;
+  Events events;
+};
+
+Result measure(lttng::Tracer& tracer, const Workload& workload, const Configuration& configuration, const Options& options)
+{
+  Result result{configuration.name, std::chrono::nanoseconds{0}, Events{0, 0}};
+
+  for (unsigned int i = 0; i < options.repetitions; i++)
+  {
+    auto path = options.directory / boost::filesystem::unique_path("lttng-overhead-%%%%-%%%%");
+
+    {
+      lttng::SessionConfig config{lttng::Domain::userspace, path.filename().string(), std::make_shared<lttng::FileSystemConsumer>(path)};
+      config.channel(configuration.channel());
+      for (auto context : configuration.contexts)
+        config.add_context(context);
+      config.enable_event(workload.events);
+
+      auto session = tracer.create_session(config);
+      session->start();
+      result.elapsed += run_timed(workload, options);
+      session->stop();
+    }
+
+    auto events = count(path);
+    result.events.recorded += events.recorded;
+    result.events.discarded += events.discarded;
+
+    boost::filesystem::remove_all(path);
+  }
+
+  return result;
+}
+
+void print_json(
+    std::ostream& out,
+    const Options& options,
+    const std::vector<std::tuple<Workload, std::chrono::nanoseconds, std::vector<Result>>>& measurements)
+{
+  double operations = static_cast<double>(options.iterations) * options.threads * options.repetitions;
+
+  out << "{\n"
+      << "  \"threads\": " << options.threads << ",\n"
+      << "  \"iterations\": " << options.iterations << ",\n"
+      << "  \"repetitions\": " << options.repetitions << ",\n"
+      << "  \"workloads\": [\n";
+
+  for (std::size_t i = 0; i < measurements.size(); i++)
+  {
+    const auto& workload = std::get<0>(measurements[i]);
+    double baseline = std::chrono::duration<double>(std::get<1>(measurements[i])).count();
+    const auto& results = std::get<2>(measurements[i]);
+
+    out << "    {\n"
+        << "      \"name\": \"" << workload.name << "\",\n"
+        << "      \"events\": \"" << workload.events << "\",\n"
+        << "      \"baseline\": {\n"
+        << "        \"seconds\": " << baseline << ",\n"
+        << "        \"operations_per_second\": " << operations / baseline << "\n"
+        << "      },\n"
+        << "      \"results\": [\n";
+
+    for (std::size_t j = 0; j < results.size(); j++)
+    {
+      const auto& r = results[j];
+      double seconds = std::chrono::duration<double>(r.elapsed).count();
+      // Discarded events have been emitted, and paid for, as well.
+      double events = r.events.recorded + r.events.discarded;
+
+      out << "        {\n"
+          << "          \"name\": \"" << r.name << "\",\n"
+          << "          \"seconds\": " << seconds << ",\n"
+          << "          \"operations_per_second\": " << operations / seconds << ",\n"
+          << "          \"throughput_loss\": " << 1. - baseline / seconds << ",\n"
+          << "          \"recorded_events\": " << r.events.recorded << ",\n"
+          << "          \"discarded_events\": " << r.events.discarded << ",\n"
+          << "          \"overhead_per_event_ns\": " << (events > 0 ? (seconds - baseline) * 1e9 / events : 0.) << "\n"
+          << "        }" << (j + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    out << "      ]\n"
+        << "    }" << (i + 1 < measurements.size() ? "," : "") << "\n";
+  }
+
+  out << "  ]\n"
+      << "}" << std::endl;
+}
+}
+
+// Call like: LD_PRELOAD="liblttng-ust-libc-wrapper.so liblttng-ust-pthread-wrapper.so" ./lttng-overhead-benchmarks --threads=4 --output=overhead.json
+int main(int argc, char** argv)
+{
+  try
+  {
+    auto options = parse_options(argc, argv);
+    auto tracer = lttng::Tracer::create(lttng::Domain::userspace);
+
+    std::vector<std::tuple<Workload, std::chrono::nanoseconds, std::vector<Result>>> measurements;
+
+    for (const auto& workload : workloads())
+    {
+      if (options.workload != "all" && options.workload != workload.name)
+        continue;
+
+      // Warm up allocator and caches before measuring the baseline.
+      run_timed(workload, options);
+
+      std::chrono::nanoseconds baseline{0};
+      for (unsigned int i = 0; i < options.repetitions; i++)
+        baseline += run_timed(workload, options);
+
+      std::vector<Result> results;
+      for (const auto& configuration : configurations())
+        results.push_back(measure(*tracer, workload, configuration, options));
+
+      measurements.push_back(std::make_tuple(workload, baseline, results));
+    }
+
+    if (measurements.empty())
+      throw std::runtime_error("Unknown workload: " + options.workload);
+
+    if (options.output.empty())
+    {
+      print_json(std::cout, options, measurements);
+    }
+    else
+    {
+      boost::filesystem::ofstream out{options.output};
+      print_json(out, options, measurements);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#ifndef CTF_CATALOG_H_
+#define CTF_CATALOG_H_
+
+#include <lttng/ctf.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace ctf
+{
+/// @brief TraceCatalog discovers all traces below a root directory in a single
+/// scan, describing them on a pool of threads, and runs analyses over all of them.
+///
+/// Every directory containing a metadata file is considered a trace. Directories
+/// below a trace are not searched any further.
+class TraceCatalog
+{
+ public:
+  /// @brief Entry describes an individual trace in the catalog.
+  struct Entry
+  {
+    boost::filesystem::path path; ///< The directory containing the metadata of the trace.
+    std::uint64_t metadata_size; ///< The size of the metadata file, in bytes.
+    std::time_t metadata_last_write_time; ///< The time the metadata file was last modified.
+    std::vector<boost::filesystem::path> streams; ///< The stream files of the trace, in lexicographical order.
+    std::uint64_t bytes; ///< The total size of all stream files, in bytes.
+    std::exception_ptr error; ///< The error that made describing the trace or searching the directory fail, if any.
+  };
+
+  /// @brief Outcome reports on running an analysis over an individual trace.
+  template<typename T>
+  struct Outcome
+  {
+    /// @brief succeeded returns true if the analysis produced a result.
+    bool succeeded() const
+    {
+      return not error;
+    }
+
+    /// @brief get returns the result of the analysis.
+    /// @throws the exception that made the analysis fail.
+    const T& get() const
+    {
+      if (error)
+        std::rethrow_exception(error);
+
+      return *result;
+    }
+
+    boost::filesystem::path path; ///< The directory containing the trace.
+    boost::optional<T> result; ///< The result of the analysis, empty if it failed.
+    std::exception_ptr error; ///< The exception that made opening or analysing the trace fail, if any.
+  };
+
+  /// @brief TraceCatalog creates a new instance, scanning the given root directory for traces.
+  ///
+  /// Traces are described on at most the given number of threads, passing 0 uses
+  /// all hardware threads. Traces that cannot be described and directories below root that cannot be searched
+  /// are reported as entries carrying an error, such that a single failure does not
+  /// hide all other traces.
+  /// @throws if the root directory cannot be read.
+  explicit TraceCatalog(const boost::filesystem::path& root, unsigned int threads = 0);
+
+  /// @brief root returns the directory that is scanned for traces.
+  const boost::filesystem::path& root() const;
+
+  /// @brief entries returns all traces found by the last scan, including errored ones, ordered by path.
+  const std::vector<Entry>& entries() const;
+
+  /// @brief rescan scans the root directory for traces again, replacing all entries.
+  /// @throws if the root directory cannot be read.
+  void rescan();
+
+  /// @brief run opens every trace in the catalog and invokes the given analysis on it.
+  ///
+  /// Failures are isolated per trace: an exception thrown while opening or analysing
+  /// a trace is reported in the trace's Outcome and does not affect any of the other
+  /// traces. Traces are analysed one after another, as babeltrace reports decoding
+  /// errors through a process-wide indicator that is neither thread-safe nor tied
+  /// to a trace. For the same reason, no other trace must be decoded concurrently.
+  ///
+  /// @returns one Outcome per entry, in the order of entries().
+  template<typename T>
+  std::vector<Outcome<T>> run(const std::function<T(Trace&, const Entry&)>& analysis) const
+  {
+    std::vector<Outcome<T>> outcomes(entries_.size());
+
+    for (std::size_t i = 0; i < entries_.size(); i++)
+    {
+      outcomes[i].path = entries_[i].path;
+
+      if (entries_[i].error)
+      {
+        outcomes[i].error = entries_[i].error;
+        continue;
+      }
+
+      try
+      {
+        Trace trace{entries_[i].path};
+        outcomes[i].result = analysis(trace, entries_[i]);
+      }
+      catch (...)
+      {
+        outcomes[i].error = std::current_exception();
+      }
+    }
+
+    return outcomes;
+  }
+
+ private:
+  boost::filesystem::path root_;
+  unsigned int threads_;
+  std::vector<Entry> entries_;
+};
+}
+
+#endif // CTF_CATALOG_H_
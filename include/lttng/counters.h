@@ -0,0 +1,94 @@
+#ifndef CTF_COUNTERS_H_
+#define CTF_COUNTERS_H_
+
+#include <lttng/ctf.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ctf
+{
+/// @brief CounterDelta describes the increase of perf counters between a pair of events recorded by a single thread.
+struct CounterDelta
+{
+  std::int64_t tid; ///< The thread both events have been recorded by.
+  std::chrono::nanoseconds begin; ///< The timestamp of the opening event.
+  std::chrono::nanoseconds duration; ///< The time elapsed between both events.
+  std::map<std::string, std::uint64_t> counters; ///< The increase of every counter present in both events, keyed by field name.
+};
+
+/// @brief CounterTotals sums the deltas of all pairs.
+struct CounterTotals
+{
+  /// @brief ratio returns the ratio of the totals of both counters, e.g., instructions per cycle.
+  /// @returns 0 if the denominator has not been recorded or is 0.
+  double ratio(const std::string& numerator, const std::string& denominator) const;
+
+  /// @brief per_pair returns the mean increase of the given counter per pair.
+  /// @returns 0 if no pair has been recorded.
+  double per_pair(const std::string& counter) const;
+
+  std::uint64_t pairs{0}; ///< Number of pairs.
+  std::chrono::nanoseconds duration{0}; ///< Time elapsed within all pairs.
+  std::map<std::string, std::uint64_t> counters; ///< Increase of every counter within all pairs, keyed by field name.
+};
+
+/// @brief CounterDeltas pairs events per thread and computes the increase of perf counters between them.
+///
+/// Counters are read from the stream event context, where lttng::Session::add_context records
+/// them under the names returned by lttng::perf_field_name. Threads are identified by their vtid
+/// or tid context, one of which must be added to the channel, too. Pairs nest: an end event
+/// closes the most recent open begin event of its thread. Kernel channels sample counters per
+/// cpu, their deltas are only meaningful for threads that did not migrate within a pair.
+///
+///   ctf::CounterDeltas deltas{"app:request_begin", "app:request_end", {"perf_thread_cpu_cycles", "perf_thread_instructions"}};
+///   trace.for_each_event([&deltas](const ctf::Event& e) { deltas.on_event(e); return ctf::Trace::ok; });
+///   auto ipc = deltas.totals().ratio("perf_thread_instructions", "perf_thread_cpu_cycles");
+class CounterDeltas
+{
+ public:
+  /// @brief Handler is invoked for every completed pair.
+  typedef std::function<void(const CounterDelta&)> Handler;
+
+  /// @brief CounterDeltas creates a new instance, pairing events named begin and end and reading the given counters.
+  CounterDeltas(
+      const std::string& begin,
+      const std::string& end,
+      const std::vector<std::string>& counters,
+      const Handler& handler = Handler{});
+
+  /// @brief on_event records the given event, if it is a begin or end event carrying a thread id.
+  /// @returns true if the event has been recorded.
+  bool on_event(const Event& event);
+
+  /// @brief totals returns the sum of the deltas of all pairs completed so far.
+  const CounterTotals& totals() const;
+
+  /// @brief open returns the number of begin events still waiting for their end event.
+  std::size_t open() const;
+
+ private:
+  // Sample holds the counters read from a begin event.
+  struct Sample
+  {
+    std::chrono::nanoseconds timestamp;
+    std::map<std::string, std::uint64_t> counters;
+  };
+
+  // Reads all counters present in the given event.
+  std::map<std::string, std::uint64_t> read(const Event& event) const;
+
+  std::string begin;
+  std::string end;
+  std::vector<std::string> counters;
+  Handler handler;
+  CounterTotals totals_;
+  std::map<std::int64_t, std::vector<Sample>> samples; ///< Open begin events per thread, most recent last.
+};
+}
+
+#endif // CTF_COUNTERS_H_
@@ -11,8 +11,11 @@
 #include <boost/variant.hpp>
 
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -80,10 +83,66 @@ class Integer
   Value value_; ///< The actual value.
 };
 
+/// @brief StringView refers to a sequence of characters owned by someone else, without copying it.
+///
+/// String fields of events refer to the buffers babeltrace decodes the fields of an
+/// event into. These are reused for the next event of the same stream, views are thus
+/// only valid while the enumerator handling the event runs. Call str() to obtain a copy
+/// that outlives the enumerator.
+class StringView
+{
+ public:
+  /// @brief Constructs the default, empty instance.
+  StringView() noexcept;
+  /// @brief Constructs an instance referring to the given null-terminated string.
+  StringView(const char* data) noexcept;
+  /// @brief Constructs an instance referring to size characters starting at data.
+  StringView(const char* data, std::size_t size) noexcept;
+  /// @brief Constructs an instance referring to the characters of the given string.
+  StringView(const std::string& s) noexcept;
+
+  /// @brief data returns a pointer to the first character referred to.
+  const char* data() const;
+
+  /// @brief size returns the number of characters referred to.
+  std::size_t size() const;
+
+  /// @brief empty returns true if no characters are referred to.
+  bool empty() const;
+
+  /// @brief begin returns an iterator to the first character referred to.
+  const char* begin() const;
+
+  /// @brief end returns an iterator past the last character referred to.
+  const char* end() const;
+
+  /// @brief str returns a copy of the characters referred to.
+  std::string str() const;
+
+ private:
+  const char* data_;
+  std::size_t size_;
+};
+
+/// @brief operator== returns true iff lhs and rhs refer to equal sequences of characters.
+bool operator==(const StringView& lhs, const StringView& rhs) noexcept(true);
+
+/// @brief operator!= returns true iff lhs and rhs refer to different sequences of characters.
+bool operator!=(const StringView& lhs, const StringView& rhs) noexcept(true);
+
+/// @brief operator< compares lhs and rhs lexicographically.
+bool operator<(const StringView& lhs, const StringView& rhs) noexcept(true);
+
+/// @brief operator<< prints the characters referred to by the given view to the given output stream.
+std::ostream& operator<<(std::ostream& out, const StringView& view);
+
 /// @brief Enumerator models a single value of an enumeration.
+///
+/// Labels are interned when an enumeration value is first seen and remain valid
+/// for the lifetime of the process.
 struct Enumerator
 {
-  std::string as_string; ///< The textual representation of the enumerator.
+  StringView as_string; ///< The textual representation of the enumerator.
   Integer as_integer; ///< The integer representation of the enumerator.
 };
 
@@ -102,7 +161,16 @@ struct Field
     untagged_variant,
     variant,
     array,
-    sequence
+    sequence,
+    // The following types do not correspond to CTF types but describe arrays and sequences
+    // whose integer or floating-point elements are stored contiguously. Fields report
+    // array or sequence as their type, but is_a(...) matches them against the representation.
+    byte_array, ///< Unsigned integers of at most 8 bits, stored as std::vector<std::uint8_t>.
+    int64_array, ///< Signed integers, stored as std::vector<std::int64_t>.
+    uint64_array, ///< Unsigned integers of more than 8 bits, stored as std::vector<std::uint64_t>.
+    floating_point_array ///< Floating-point values, stored as std::vector<double>.
+    // Arrays and sequences of UTF-8 or ASCII encoded characters, like the procname context,
+    // are stored as StringView, up to the first null character, and match Type::string.
   };
 
   /// @brief Variant carries the values of a field.
@@ -112,9 +180,13 @@ struct Field
     Integer, // An integer is contained within this field's value.
     double, // A floating-point value is contained within this field's value.
     Enumerator, // An enumerator is contained within this field's value.
-    std::string, // A string is contained within this field's value.
+    StringView, // A string is contained within this field's value, referring to babeltrace's field buffer.
     boost::recursive_variant_, // A variant can contain itself, being a so-called boxed-type.
-    std::vector<boost::recursive_variant_> // A variant can be a collection of arbitrary values.
+    std::vector<boost::recursive_variant_>, // A variant can be a collection of arbitrary values.
+    std::vector<std::uint8_t>, // Contiguous bytes of an array or sequence.
+    std::vector<std::int64_t>, // Contiguous signed integers of an array or sequence.
+    std::vector<std::uint64_t>, // Contiguous unsigned integers of an array or sequence.
+    std::vector<double> // Contiguous floating-point values of an array or sequence.
   >::type Variant;
 
   /// @brief Field constructs a new instance with the given parameters.
@@ -124,7 +196,14 @@ struct Field
   /// @brief type returns the type of the value contained in this field.
   Type type() const;
 
-  // @brief is_a returns true if the contained value is of the given type.
+  /// @brief is_a returns true if the contained value is of the given type.
+  ///
+  /// Type::array and Type::sequence only match if the elements are stored as
+  /// a collection of Variant instances. Arrays and sequences of integers or
+  /// floating-point values match Type::byte_array, Type::int64_array,
+  /// Type::uint64_array or Type::floating_point_array instead. Empty arrays and
+  /// sequences match Type::array or Type::sequence, and all contiguous types,
+  /// reading as empty buffers. Arrays and sequences of characters match Type::string.
   bool is_a(Type type) const;
 
   /// @brief name returns a const reference to the name of the field.
@@ -145,9 +224,15 @@ struct Field
   /// @brief throws boost::bad_cast in case of issues.
   const Enumerator& as_enumerator() const;
 
-  /// @brief as_string tries to interpret the contained value as a string.
+  /// @brief as_string tries to interpret the contained value as a string, returning a copy of it.
   /// @brief throws boost::bad_cast in case of issues.
-  const std::string& as_string() const;
+  std::string as_string() const;
+
+  /// @brief as_string_view tries to interpret the contained value as a string, without copying it.
+  ///
+  /// The view is only valid while the enumerator handling the event runs.
+  /// @brief throws boost::bad_cast in case of issues.
+  const StringView& as_string_view() const;
 
   /// @brief unwrap tries to interpret the contained value as a variant.
   /// @brief throws boost::bad_cast in case of issues.
@@ -157,6 +242,22 @@ struct Field
   /// @brief throws boost::bad_cast in case of issues.
   const std::vector<Variant>& as_collection() const;
 
+  /// @brief as_bytes tries to interpret the contained value as an array of bytes.
+  /// @brief throws boost::bad_cast in case of issues.
+  const std::vector<std::uint8_t>& as_bytes() const;
+
+  /// @brief as_int64_array tries to interpret the contained value as an array of signed integers.
+  /// @brief throws boost::bad_cast in case of issues.
+  const std::vector<std::int64_t>& as_int64_array() const;
+
+  /// @brief as_uint64_array tries to interpret the contained value as an array of unsigned integers.
+  /// @brief throws boost::bad_cast in case of issues.
+  const std::vector<std::uint64_t>& as_uint64_array() const;
+
+  /// @brief as_floating_point_array tries to interpret the contained value as an array of doubles.
+  /// @brief throws boost::bad_cast in case of issues.
+  const std::vector<double>& as_floating_point_array() const;
+
  private:
   std::string name_;
   Type type_;
@@ -207,11 +308,11 @@ struct TypeMapper<Field::Type::enumeration>
 template<>
 struct TypeMapper<Field::Type::string>
 {
-  typedef std::string Type;
+  typedef StringView Type;
 
-  static const std::string& extract(const Field& f)
+  static const StringView& extract(const Field& f)
   {
-    return f.as_string();
+    return f.as_string_view();
   }
 };
 
@@ -270,6 +371,50 @@ struct TypeMapper<Field::Type::sequence>
   }
 };
 
+template<>
+struct TypeMapper<Field::Type::byte_array>
+{
+  typedef std::vector<std::uint8_t> Type;
+
+  static const std::vector<std::uint8_t>& extract(const Field& f)
+  {
+    return f.as_bytes();
+  }
+};
+
+template<>
+struct TypeMapper<Field::Type::int64_array>
+{
+  typedef std::vector<std::int64_t> Type;
+
+  static const std::vector<std::int64_t>& extract(const Field& f)
+  {
+    return f.as_int64_array();
+  }
+};
+
+template<>
+struct TypeMapper<Field::Type::uint64_array>
+{
+  typedef std::vector<std::uint64_t> Type;
+
+  static const std::vector<std::uint64_t>& extract(const Field& f)
+  {
+    return f.as_uint64_array();
+  }
+};
+
+template<>
+struct TypeMapper<Field::Type::floating_point_array>
+{
+  typedef std::vector<double> Type;
+
+  static const std::vector<double>& extract(const Field& f)
+  {
+    return f.as_floating_point_array();
+  }
+};
+
 /// @brief Pretty prints the given integer to the given output stream.
 std::ostream& operator<<(std::ostream& out, const Integer& integer);
 
@@ -371,6 +516,122 @@ class FieldSpec
   std::string name;
 };
 
+/// @brief Sampling describes how an iteration of a trace decimates the events handed to an enumerator.
+///
+/// Sampling is meant for first-look analyses of huge traces: aggregates computed
+/// over a sampled iteration are scaled by the rates reported in a SamplingReport.
+struct Sampling
+{
+  /// @brief Mode enumerates the known sampling strategies.
+  enum class Mode
+  {
+    none, ///< Every event is handed out.
+    every_nth_per_event_class, ///< One in n events of every event class is handed out.
+    bernoulli, ///< Every event is handed out independently with a fixed probability.
+    packets ///< All events of one in n packets of every stream are handed out, see Trace::for_each_event for the cost of the others.
+  };
+
+  /// @brief none returns a Sampling instance that hands out every event.
+  static Sampling none();
+
+  /// @brief every_nth_per_event_class returns a Sampling instance handing out the first and then every n-th event of every event class.
+  /// @throws std::invalid_argument if n is 0.
+  static Sampling every_nth_per_event_class(std::uint64_t n);
+
+  /// @brief bernoulli returns a Sampling instance handing out every event with the given probability.
+  /// Decisions are drawn from a pseudo-random generator seeded with seed, making iterations reproducible.
+  /// @throws std::invalid_argument if probability is not in [0, 1].
+  static Sampling bernoulli(double probability, std::uint64_t seed);
+
+  /// @brief packets returns a Sampling instance handing out the first and then every n-th packet of every stream.
+  /// @throws std::invalid_argument if n is 0.
+  static Sampling packets(std::uint64_t n);
+
+  Mode mode; ///< The sampling strategy.
+  std::uint64_t n; ///< Decimation factor for Mode::every_nth_per_event_class and Mode::packets.
+  double probability; ///< Probability of handing out an event for Mode::bernoulli.
+  std::uint64_t seed; ///< Seed of the pseudo-random generator for Mode::bernoulli.
+};
+
+/// @brief SamplingReport summarizes the effective sampling rates of an iteration.
+struct SamplingReport
+{
+  /// @brief Counters relates the number of items seen in a trace to the number of items handed out.
+  struct Counters
+  {
+    /// @brief rate returns the effective sampling rate, i.e., delivered / seen, or 1 if nothing has been seen.
+    double rate() const;
+
+    /// @brief scale returns the factor that aggregates over delivered items have to be multiplied with, i.e., 1 / rate().
+    ///
+    /// Returns 0 if nothing has been delivered, as seen items cannot be extrapolated
+    /// from an empty sample. Aggregates then stay 0, check seen to detect this case.
+    double scale() const;
+
+    std::uint64_t seen; ///< The number of items seen during iteration.
+    std::uint64_t delivered; ///< The number of items handed out to the enumerator.
+  };
+
+  Counters events; ///< Events over all event classes.
+  Counters packets; ///< Packets over all streams, only tracked for Sampling::Mode::packets.
+  std::map<std::string, Counters> per_event_class; ///< Events per event class, keyed by event name.
+};
+
+/// @brief Ordering enumerates the orders in which the events of a trace can be walked.
+enum class Ordering
+{
+  timestamp, ///< Events of all streams are merged in global timestamp order.
+  none ///< Streams are walked one after another, each in its own order, without merging them.
+};
+
+/// @brief Statistics is a snapshot of the instrumentation counters of an iteration of a trace.
+///
+/// The time spent in babeltrace, reading packets and walking events, is the part of elapsed
+/// that is neither spent decoding fields nor in the enumerator, see reader_time().
+/// Heap allocations are not tracked, the lttng-benchmarks target counts them per event.
+struct Statistics
+{
+  /// @brief reader_time returns the time spent in babeltrace, i.e., elapsed - decode_time - enumerator_time.
+  std::chrono::nanoseconds reader_time() const;
+
+  std::uint64_t events; ///< Events walked, including the ones skipped by sampling.
+  std::uint64_t decoded_events; ///< Events decoded and handed to the enumerator.
+  std::uint64_t bytes; ///< Bytes of all packets read, as announced by their packet context.
+  std::chrono::nanoseconds elapsed; ///< Wall-clock time of the iteration.
+  std::chrono::nanoseconds decode_time; ///< Time spent decoding the fields of events.
+  std::chrono::nanoseconds enumerator_time; ///< Time spent in the enumerator.
+  std::map<std::string, std::uint64_t> per_event_class; ///< Events walked per event class, keyed by event name.
+  std::map<std::tuple<std::uint64_t, std::uint64_t>, std::uint64_t> packets_per_stream; ///< Packets read per stream, keyed by (stream_id, cpu_id).
+};
+
+/// @brief Instrumentation configures the opt-in instrumentation of trace iterations.
+struct Instrumentation
+{
+  /// @brief ProgressHandler is invoked periodically during an iteration with a snapshot of the counters.
+  typedef std::function<void(const Statistics&)> ProgressHandler;
+
+  ProgressHandler on_progress; ///< Invoked periodically if set.
+  std::chrono::milliseconds progress_interval; ///< Minimum time between two invocations of on_progress.
+};
+
+/// @brief Prefetching configures the I/O scheduling of iterations of a trace.
+///
+/// Stream files are flagged for sequential access. For streams with an lttng
+/// packet index, a background thread asks the kernel to read the packets ahead
+/// of the current position into the page cache and to drop the packets behind
+/// it, keeping decoding CPU-bound on cold traces. Streams without index are left
+/// to the kernel's sequential readahead: their read position cannot be related to
+/// offsets in the file, so neither packets_ahead nor drop_behind apply to them.
+struct Prefetching
+{
+  /// @brief defaults returns a configuration prefetching 8 packets per stream, dropping read packets.
+  static Prefetching defaults();
+
+  std::uint32_t packets_ahead; ///< Number of packets to keep prefetched per stream.
+  bool drop_behind; ///< Drop packets that have been read from the page cache.
+  std::chrono::milliseconds interval; ///< Time between two rounds of the background thread.
+};
+
 /// @brief Trace models an individul recording of events in CTF (Common Trace Format).
 class Trace
 {
@@ -388,12 +649,43 @@ class Trace
   /// for every event in a trace.
   typedef std::function<EventEnumeratorReply(const Event&)> EventEnumerator;
   
+  /// @brief Buffer refers to bytes held in memory, e.g., an mmap'd region,
+  /// a shared-memory segment or data extracted from an archive.
+  struct Buffer
+  {
+    const void* data; ///< The first byte of the buffer.
+    std::size_t size; ///< The size of the buffer in bytes.
+  };
+
+  /// @brief StreamBuffers maps names of stream files to their contents.
+  typedef std::map<std::string, Buffer> StreamBuffers;
+
+  /// @brief StreamFiles maps names of stream files to readable file descriptors holding their contents.
+  typedef std::map<std::string, int> StreamFiles;
+
   /// @brief Trace creates a new instance, loading data from the given path.
   /// @throws if opening the trace fails.
   Trace(const boost::filesystem::path& path);
+
+  /// @brief Trace creates a new instance, loading data from the given metadata and stream buffers.
+  ///
+  /// The contents of the buffers are copied to anonymous memory files that babeltrace
+  /// reads from, such that the buffers can be released once the constructor returns.
+  /// Nothing is written to disk.
+  /// @throws if opening the trace fails.
+  Trace(const Buffer& metadata, const StreamBuffers& streams);
+
+  /// @brief Trace creates a new instance, loading data from the given metadata and stream files.
+  ///
+  /// Other than for buffers, nothing is copied: babeltrace reads straight from the
+  /// files, e.g., memfds or shared-memory objects the caller already holds. The
+  /// descriptors remain owned by the caller and must stay open for the lifetime of
+  /// this instance.
+  /// @throws if any of the descriptors is invalid or opening the trace fails.
+  Trace(int metadata, const StreamFiles& streams);
   Trace(const Trace&) = delete;
   Trace(Trace&&) = delete;
-  virtual ~Trace() = default;
+  virtual ~Trace();
   
   Trace& operator=(const Trace&) = delete;
   Trace& operator=(Trace&&) = delete;
@@ -401,10 +693,135 @@ class Trace
   /// @brief for_each_event iterates over this trace, invoking the given enumerator for every event.
   virtual void for_each_event(EventEnumerator enumerator);
 
+  /// @brief for_each_event iterates over this trace in the given order, invoking the given enumerator for every event.
+  ///
+  /// Ordering::none suits order-insensitive consumers like counters and histograms:
+  /// only one stream is open at a time and its file is read sequentially.
+  virtual void for_each_event(EventEnumerator enumerator, Ordering ordering);
+
+  /// @brief for_each_event iterates over this trace in the given order, invoking the given enumerator for every event selected by sampling.
+  ///
+  /// Sampling saves the cost of assembling Event instances and of the enumerator, not the
+  /// cost of reading a trace: babeltrace 1.x offers no public means to seek past a packet,
+  /// so every packet is still read from disk and every event is still parsed by babeltrace.
+  /// With Sampling::Mode::packets, events of skipped packets are rejected by looking at their
+  /// packet context only.
+  ///
+  /// @returns the effective sampling rates of the iteration.
+  virtual SamplingReport for_each_event(EventEnumerator enumerator, const Sampling& sampling, Ordering ordering = Ordering::timestamp);
+
+  /// @brief RawEventEnumerator is a functor that is passed to for_each_raw_event and
+  /// invoked for every event in a trace, with babeltrace's representation of the event.
+  typedef std::function<EventEnumeratorReply(const bt_ctf_event*)> RawEventEnumerator;
+
+  /// @brief for_each_raw_event iterates over this trace in the given order, invoking the given enumerator for every event.
+  ///
+  /// Events are handed out without decoding any of their fields, for consumers reading
+  /// fields through babeltrace directly, like EventView. Sampling and instrumentation
+  /// do not apply.
+  virtual void for_each_raw_event(RawEventEnumerator enumerator, Ordering ordering = Ordering::timestamp);
+
+  /// @brief ContextHandler is invoked before the events of every babeltrace context are handed out.
+  typedef std::function<void()> ContextHandler;
+
+  /// @brief for_each_raw_event iterates over this trace in the given order, invoking the given enumerator for every event.
+  ///
+  /// Declarations and definitions reachable from the handed out events are owned by a babeltrace
+  /// context, and Ordering::none reads every stream through a context of its own. Their addresses
+  /// might be reused once a context is gone, consumers caching them clear their caches in on_context.
+  virtual void for_each_raw_event(RawEventEnumerator enumerator, Ordering ordering, ContextHandler on_context);
+
+  /// @brief enable_instrumentation makes subsequent iterations record Statistics.
+  ///
+  /// Iterations of a trace without instrumentation do not pay for it.
+  virtual void enable_instrumentation(const Instrumentation& instrumentation);
+
+  /// @brief disable_instrumentation stops recording Statistics for subsequent iterations.
+  virtual void disable_instrumentation();
+
+  /// @brief statistics returns a snapshot of the counters recorded during the last instrumented iteration.
+  virtual Statistics statistics() const;
+
+  /// @brief enable_prefetching makes subsequent iterations of this trace schedule I/O according to the given configuration.
+  virtual void enable_prefetching(const Prefetching& prefetching);
+
+  /// @brief disable_prefetching leaves I/O of subsequent iterations to the kernel's default readahead.
+  virtual void disable_prefetching();
+
+  /// @brief Cursor walks the events of a trace on demand, in timestamp order.
+  ///
+  /// Cursors allow for consuming multiple traces in lockstep. babeltrace supports
+  /// a single iteration per trace at a time: a trace must not be iterated with
+  /// for_each_event while a cursor on it is alive, and at most one cursor per
+  /// trace may exist at a time.
+  class Cursor
+  {
+   public:
+    /// @brief Cursor creates a new instance positioned before the first event of the given trace.
+    /// @throws std::runtime_error if the trace cannot be iterated.
+    explicit Cursor(Trace& trace);
+    Cursor(const Cursor&) = delete;
+    ~Cursor();
+
+    Cursor& operator=(const Cursor&) = delete;
+
+    /// @brief next advances to the next event of the trace and decodes it into event.
+    ///
+    /// Strings in the event refer to babeltrace's buffers and are valid until the next call to next().
+    /// @returns false if the end of the trace has been reached, leaving event untouched.
+    /// @throws std::runtime_error in case of decoding issues.
+    bool next(Event& event);
+
+   private:
+    struct Private;
+    std::unique_ptr<Private> d;
+  };
+
  private:
   boost::filesystem::path path_;
   bt_context* context;
   int trace_handle;
+  boost::optional<Instrumentation> instrumentation_;
+  boost::optional<Prefetching> prefetching_;
+  Statistics statistics_;
+  std::vector<int> memory_files_; ///< Anonymous memory files backing a trace loaded from buffers.
+  bool in_memory_; ///< True if path_ only presents files held in memory and is removed on destruction.
+
+  friend class Dispatcher;
+};
+
+/// @brief Dispatcher runs many analyses over a trace in a single pass.
+///
+/// Analyses register with the events and fields they need. A run decodes
+/// only the union of the fields requested for an event class and routes every
+/// event through a per-event-class table to the interested analyses only.
+/// Events no analysis is interested in are skipped without decoding them.
+class Dispatcher
+{
+ public:
+  /// @brief Handler is invoked for every event an analysis is interested in.
+  typedef std::function<void(const Event&)> Handler;
+
+  /// @brief Interest describes the events and fields an analysis needs.
+  ///
+  /// Handlers might see more fields than they asked for, if other analyses
+  /// interested in the same event class requested them.
+  struct Interest
+  {
+    std::set<std::string> events; ///< Names of the events of interest, empty for all events.
+    std::vector<Event::Key> fields; ///< The fields to decode. Fields missing in an event are skipped.
+    bool all_fields; ///< Decode all fields of the events of interest, regardless of fields.
+  };
+
+  /// @brief add registers an analysis with the given interest and handler.
+  void add(const Interest& interest, const Handler& handler);
+
+  /// @brief run walks the given trace once in the given order, dispatching to all registered analyses.
+  /// @throws std::runtime_error in case of issues.
+  void run(Trace& trace, Ordering ordering = Ordering::timestamp);
+
+ private:
+  std::vector<std::tuple<Interest, Handler>> analyses;
 };
 }
 
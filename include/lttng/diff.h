@@ -0,0 +1,95 @@
+#ifndef CTF_DIFF_H_
+#define CTF_DIFF_H_
+
+#include <lttng/ctf.h>
+#include <lttng/histogram.h>
+
+#include <boost/optional.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ctf
+{
+/// @brief diff compares a baseline and a candidate trace of the same workload in
+/// a single streaming pass, to spot performance regressions between both runs.
+namespace diff
+{
+/// @brief Histogram approximates a distribution of durations with power-of-two buckets.
+typedef lttng::Histogram Histogram;
+
+/// @brief EventClassReport compares a single event class across both traces.
+///
+/// The latency of an event is the time elapsed since the previous event sharing
+/// its key fields, e.g., the time a thread spent before reaching the event.
+struct EventClassReport
+{
+  /// @brief delta returns the difference of the candidate and the baseline count.
+  std::int64_t delta() const;
+
+  /// @brief shift returns the difference of the candidate and the baseline latency q-quantile.
+  std::chrono::nanoseconds shift(double q) const;
+
+  std::uint64_t baseline{0}; ///< Number of events in the baseline trace.
+  std::uint64_t candidate{0}; ///< Number of events in the candidate trace.
+  Histogram baseline_latency; ///< Latency distribution in the baseline trace.
+  Histogram candidate_latency; ///< Latency distribution in the candidate trace.
+};
+
+/// @brief Divergence describes the first point at which both traces stop aligning.
+struct Divergence
+{
+  std::string key; ///< The values of the key fields of the diverging events.
+  std::uint64_t index; ///< The position of the diverging events among all events sharing the key.
+  std::string baseline; ///< The name of the baseline event. Empty if the baseline has no event at this position.
+  std::string candidate; ///< The name of the candidate event. Empty if the candidate has no event at this position.
+  std::chrono::nanoseconds offset; ///< Time since the start of its trace of the earlier of both events.
+};
+
+/// @brief Options configures a comparison.
+struct Options
+{
+  /// @brief Fields that, next to the event name, identify corresponding events in both traces.
+  ///
+  /// Events are aligned within groups sharing the values of all key fields, in
+  /// timestamp order. Key fields must be stable across runs: cpu ids or process
+  /// names are, thread ids usually are not. Without key fields, all events form
+  /// a single group, which only aligns for single-threaded workloads.
+  std::vector<Event::Key> key_fields;
+
+  /// @brief Maximum number of events that one trace may be ahead of the other while aligning.
+  ///
+  /// Bounds the memory used for alignment. Exceeding it counts as divergence.
+  std::size_t window{4096};
+};
+
+/// @brief Report summarizes a comparison.
+struct Report
+{
+  std::uint64_t baseline_events{0}; ///< Number of events in the baseline trace.
+  std::uint64_t candidate_events{0}; ///< Number of events in the candidate trace.
+  std::map<std::string, EventClassReport> per_event_class; ///< Comparison per event class, keyed by event name.
+  boost::optional<Divergence> first_divergence; ///< The first divergence, empty if both traces align.
+};
+
+/// @brief compare walks both traces in lockstep and compares them.
+///
+/// Events are consumed from both traces ordered by their offset to the first
+/// event of the respective trace. Memory usage is bounded by the window and the
+/// number of distinct keys up to the first divergence, independent of the size
+/// of the traces. Beyond it, latencies are only tracked for keys seen before.
+/// @throws std::runtime_error in case of issues.
+Report compare(Trace& baseline, Trace& candidate, const Options& options = Options{});
+
+/// @brief operator<< pretty prints the given report to the given output stream.
+std::ostream& operator<<(std::ostream& out, const Report& report);
+}
+}
+
+#endif // CTF_DIFF_H_
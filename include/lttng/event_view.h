@@ -0,0 +1,308 @@
+#ifndef CTF_EVENT_VIEW_H_
+#define CTF_EVENT_VIEW_H_
+
+#include <lttng/ctf.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+namespace ctf
+{
+namespace view
+{
+/// @brief Field describes a field in the given scope, decoded into a value of type T.
+///
+/// T is an arithmetic type for integer, enumeration and floating-point fields, and
+/// either std::string or StringView for string fields and for arrays and sequences of
+/// characters, like the procname context. Enumerations decode to their integer value.
+template<Scope s, typename T>
+struct Field
+{
+  static constexpr Scope scope = s; ///< The scope of the field.
+  typedef T Type; ///< The C++ type the field is decoded into.
+};
+
+/// @cond
+namespace detail
+{
+// Reader enumerates the babeltrace accessors that a field is read with.
+enum class Reader
+{
+  uint64,
+  int64,
+  floating_point,
+  string,
+  char_array
+};
+
+// Returns the def to read the value of the given def from, unwrapping enumerations.
+inline const bt_definition* unwrap(const bt_definition* def)
+{
+  auto decl = bt_ctf_get_decl_from_def(def);
+  return bt_ctf_field_type(decl) == CTF_TYPE_ENUM ? bt_ctf_get_enum_int(def) : def;
+}
+
+// Returns true if the given array or sequence def holds UTF-8 or ASCII encoded characters.
+inline bool is_char_array(const bt_ctf_event* e, const bt_definition* def)
+{
+  unsigned int count(0); bt_definition const* const* defs(nullptr);
+
+  if (bt_ctf_get_field_list(e, def, &defs, &count) != 0 || count == 0)
+    return false;
+
+  auto decl = bt_ctf_get_decl_from_def(defs[0]);
+  auto encoding = bt_ctf_get_encoding(decl);
+
+  return bt_ctf_field_type(decl) == CTF_TYPE_INTEGER && bt_ctf_get_int_len(decl) == 8 &&
+      (encoding == CTF_STRING_UTF8 || encoding == CTF_STRING_ASCII);
+}
+
+// Returns the reader for the given def, or throws if it cannot be decoded into T.
+template<typename T>
+Reader reader_for(const bt_ctf_event* e, const bt_definition* def, const std::string& name)
+{
+  auto decl = bt_ctf_get_decl_from_def(unwrap(def));
+  bool textual = std::is_same<T, std::string>::value || std::is_same<T, StringView>::value;
+
+  switch (bt_ctf_field_type(decl))
+  {
+    case CTF_TYPE_INTEGER:
+      if (std::is_arithmetic<T>::value)
+        return bt_ctf_get_int_signedness(decl) ? Reader::int64 : Reader::uint64;
+      break;
+    case CTF_TYPE_FLOAT:
+      if (std::is_arithmetic<T>::value)
+        return Reader::floating_point;
+      break;
+    case CTF_TYPE_STRING:
+      if (textual)
+        return Reader::string;
+      break;
+    case CTF_TYPE_ARRAY:
+    case CTF_TYPE_SEQUENCE:
+      if (textual && is_char_array(e, def))
+        return Reader::char_array;
+      break;
+    default:
+      break;
+  }
+
+  throw std::runtime_error("EventView: field " + name + " cannot be decoded into the requested type");
+}
+
+template<typename T, bool arithmetic = std::is_arithmetic<T>::value>
+struct Decode
+{
+  static T from(const bt_definition* def, Reader reader)
+  {
+    switch (reader)
+    {
+      case Reader::uint64:
+        return static_cast<T>(bt_ctf_get_uint64(unwrap(def)));
+      case Reader::int64:
+        return static_cast<T>(bt_ctf_get_int64(unwrap(def)));
+      case Reader::floating_point:
+        return static_cast<T>(bt_ctf_get_float(def));
+      default:
+        return T{};
+    }
+  }
+};
+
+template<typename T>
+struct Decode<T, false>
+{
+  static T from(const bt_definition* def, Reader reader)
+  {
+    auto s = reader == Reader::char_array ? bt_ctf_get_char_array(def) : bt_ctf_get_string(def);
+    return s ? T(s) : T();
+  }
+};
+
+// Slot is the resolved position of a field within the field list of its scope.
+struct Slot
+{
+  unsigned int index;
+  Reader reader;
+};
+}
+/// @endcond
+}
+
+/// @brief EventView decodes a fixed set of fields of a single event class directly into C++ types.
+///
+/// The position of every field is resolved once per event class. Afterwards,
+/// decoding an event amounts to reading the fields from their known positions,
+/// without assembling an Event, Field or Integer instances:
+///
+///   EventView<view::Field<Scope::event_fields, std::uint64_t>,
+///             view::Field<Scope::stream_event_context, std::int64_t>> malloc{"ust_libc:malloc", {{"size", "vpid"}}};
+///
+///   malloc.for_each_event(trace, [](const std::tuple<std::uint64_t, std::int64_t>& values) { ... });
+///
+/// Field names are passed at runtime, as C++11 does not support strings as template arguments.
+template<typename... Fields>
+class EventView
+{
+ public:
+  /// @brief Values carries the decoded values of all fields, in order.
+  typedef std::tuple<typename Fields::Type...> Values;
+
+  /// @brief Handler is invoked with the values of every event of the viewed class.
+  typedef std::function<Trace::EventEnumeratorReply(const Values&)> Handler;
+
+  /// @brief Names lists the names of all fields, in order.
+  typedef std::array<std::string, sizeof...(Fields)> Names;
+
+  /// @brief EventView creates a new instance viewing the fields with the given names of the events with the given name.
+  EventView(const std::string& event, const Names& names)
+      : event(event),
+        names(names),
+        last_decl(nullptr),
+        last_resolution(nullptr)
+  {
+  }
+
+  /// @brief extract decodes the fields of the given babeltrace event into values.
+  ///
+  /// Strings decoded into StringView refer to babeltrace's field buffers and are only valid while the event is visited.
+  /// @returns false if the event is not of the viewed class or lacks any of the fields.
+  /// @throws std::runtime_error if a field cannot be decoded into the requested type.
+  bool extract(const bt_ctf_event* e, Values& values)
+  {
+    const auto& resolution = resolve(e);
+
+    if (not resolution.matches)
+      return false;
+
+    decode<0, Fields...>(e, resolution, values);
+    return true;
+  }
+
+  /// @brief for_each_event walks the given trace in the given order, invoking handler for every event of the viewed class.
+  /// @throws std::runtime_error in case of issues.
+  void for_each_event(Trace& trace, const Handler& handler, Ordering ordering = Ordering::timestamp)
+  {
+    Values values;
+
+    trace.for_each_raw_event([this, &handler, &values](const bt_ctf_event* e)
+    {
+      if (not extract(e, values))
+        return Trace::EventEnumeratorReply::ok;
+
+      return handler(values);
+    }, ordering, [this]() { clear(); });
+
+    clear();
+  }
+
+  /// @brief clear forgets all resolved event classes.
+  ///
+  /// Declarations are only valid for the babeltrace context they were created in, and their
+  /// addresses might be reused by another context. Callers of extract invoke clear whenever
+  /// they switch contexts.
+  void clear()
+  {
+    resolutions.clear();
+    last_decl = nullptr;
+    last_resolution = nullptr;
+  }
+
+ private:
+  struct Resolution
+  {
+    bool matches;
+    std::array<view::detail::Slot, sizeof...(Fields)> slots;
+  };
+
+  const Resolution& resolve(const bt_ctf_event* e)
+  {
+    auto decl = bt_ctf_event_get_decl(e);
+
+    // Consecutive events are likely of the same class.
+    if (decl == last_decl)
+      return *last_resolution;
+
+    auto it = resolutions.find(decl);
+
+    if (it == resolutions.end())
+    {
+      Resolution resolution;
+      resolution.matches = event == bt_ctf_get_decl_event_name(decl) && resolve_slots<0, Fields...>(e, resolution);
+      it = resolutions.insert(std::make_pair(decl, resolution)).first;
+    }
+
+    last_decl = decl;
+    last_resolution = &it->second;
+    return it->second;
+  }
+
+  template<std::size_t i>
+  bool resolve_slots(const bt_ctf_event*, Resolution&)
+  {
+    return true;
+  }
+
+  template<std::size_t i, typename Head, typename... Tail>
+  bool resolve_slots(const bt_ctf_event* e, Resolution& resolution)
+  {
+    unsigned int count(0); bt_definition const* const* defs(nullptr);
+    auto scope = bt_ctf_get_top_level_scope(e, static_cast<bt_ctf_scope>(Head::scope));
+
+    if (not scope || bt_ctf_get_field_list(e, scope, &defs, &count) != 0)
+      return false;
+
+    for (unsigned int j = 0; j < count; j++)
+    {
+      std::string name{bt_ctf_field_name(defs[j])};
+
+      // lttng prefixes field names with an underscore.
+      if (name == names[i] || name == "_" + names[i])
+      {
+        resolution.slots[i] = view::detail::Slot{j, view::detail::reader_for<typename Head::Type>(e, defs[j], names[i])};
+        return resolve_slots<i + 1, Tail...>(e, resolution);
+      }
+    }
+
+    return false;
+  }
+
+  template<std::size_t i>
+  void decode(const bt_ctf_event*, const Resolution&, Values&)
+  {
+  }
+
+  template<std::size_t i, typename Head, typename... Tail>
+  void decode(const bt_ctf_event* e, const Resolution& resolution, Values& values)
+  {
+    unsigned int count(0); bt_definition const* const* defs(nullptr);
+    auto scope = bt_ctf_get_top_level_scope(e, static_cast<bt_ctf_scope>(Head::scope));
+
+    const auto& slot = resolution.slots[i];
+
+    if (not scope || bt_ctf_get_field_list(e, scope, &defs, &count) != 0 || slot.index >= count)
+      throw std::runtime_error("EventView: field " + names[i] + " is missing from the event");
+
+    std::get<i>(values) = view::detail::Decode<typename Head::Type>::from(defs[slot.index], slot.reader);
+
+    if (bt_ctf_field_get_error() < 0)
+      throw std::runtime_error("EventView: error while decoding field " + names[i]);
+
+    decode<i + 1, Tail...>(e, resolution, values);
+  }
+
+  std::string event;
+  Names names;
+  std::unordered_map<const bt_ctf_event_decl*, Resolution> resolutions;
+  const bt_ctf_event_decl* last_decl;
+  const Resolution* last_resolution;
+};
+}
+
+#endif // CTF_EVENT_VIEW_H_
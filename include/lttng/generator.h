@@ -0,0 +1,68 @@
+#ifndef CTF_GENERATOR_H_
+#define CTF_GENERATOR_H_
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace ctf
+{
+/// @brief generator writes synthetic, valid CTF traces mimicking the layout
+/// of lttng-ust sessions, such that readers and benchmarks can be exercised
+/// deterministically without recording traces with a session daemon.
+namespace generator
+{
+/// @brief Mix enumerates the event mixes that generated traces can carry.
+enum class Mix
+{
+  libc, ///< ust_libc events: malloc, calloc, realloc, memalign, posix_memalign and free.
+  pthread, ///< ust_pthread mutex events.
+  mixed, ///< libc and pthread events, plus periodic ust_baddr_statedump:soinfo events.
+  strings, ///< ust_baddr_statedump:soinfo events only, stressing string decoding.
+  types ///< ust_generator:types events only, carrying an enumeration, a sequence of integers that is empty for every fourth event, a byte array and a floating-point value.
+};
+
+/// @brief operator>> reads a Mix from the given input stream.
+std::istream& operator>>(std::istream& in, Mix& mix);
+
+/// @brief operator<< pretty prints the given mix to the given output stream.
+std::ostream& operator<<(std::ostream& out, Mix mix);
+
+/// @brief Shape describes size and shape of a generated trace.
+///
+/// Every stream carries the vpid, vtid, procname and ip contexts. At least one
+/// of events and bytes has to be non-zero; generation of a stream stops as soon
+/// as either limit is reached.
+struct Shape
+{
+  std::uint64_t events; ///< Total number of events, distributed evenly over all streams. 0 for no limit.
+  std::uint64_t bytes; ///< Approximate total size of all stream files in bytes, each padded to whole packets. 0 for no limit.
+  std::uint32_t streams; ///< Number of stream files, one per (virtual) cpu.
+  std::uint32_t packet_size; ///< Size of a packet in bytes.
+  std::uint32_t processes; ///< Number of distinct vpids the events are attributed to.
+  std::uint64_t events_per_second; ///< Event rate per stream, determining the timestamps of events.
+  std::uint64_t seed; ///< Seed for all pseudo-random choices, making generation reproducible.
+  Mix mix; ///< The event mix.
+};
+
+/// @brief default_shape returns a Shape describing a 4-stream trace of 1 million mixed events.
+Shape default_shape();
+
+/// @brief Summary reports on a generated trace.
+struct Summary
+{
+  std::uint64_t events; ///< Number of events written.
+  std::uint64_t bytes; ///< Number of bytes written, including metadata.
+};
+
+/// @brief generate writes a trace of the given shape to the given directory,
+/// generating streams in parallel on up to the given number of threads.
+///
+/// Passing 0 threads uses all hardware threads.
+/// @throws std::runtime_error in case of issues.
+Summary generate(const boost::filesystem::path& dir, const Shape& shape, unsigned int threads = 0);
+}
+}
+
+#endif // CTF_GENERATOR_H_
@@ -0,0 +1,27 @@
+#ifndef LTTNG_HISTOGRAM_H_
+#define LTTNG_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace lttng
+{
+/// @brief Histogram approximates a distribution of durations with power-of-two buckets.
+///
+/// Bucket i counts durations d with 2^i <= d + 1 < 2^(i+1) nanoseconds.
+struct Histogram
+{
+  /// @brief add records the given duration. Negative durations are recorded as 0.
+  void add(std::chrono::nanoseconds duration);
+
+  /// @brief quantile returns the upper bound of the bucket containing the q-quantile, with q in [0, 1].
+  /// @returns 0 if the histogram is empty, std::chrono::nanoseconds::max() for the last bucket.
+  std::chrono::nanoseconds quantile(double q) const;
+
+  std::uint64_t count{0}; ///< Number of recorded durations.
+  std::array<std::uint64_t, 64> buckets{}; ///< Number of recorded durations per bucket.
+};
+}
+
+#endif // LTTNG_HISTOGRAM_H_
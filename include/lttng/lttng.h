@@ -1,11 +1,21 @@
 #ifndef LTTNG_H_
 #define LTTNG_H_
 
+#include <lttng/histogram.h>
+
+#include <boost/asio/io_service.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -98,6 +108,47 @@ enum Context
 /// @brief operator<< pretty prints the given context to the given output stream.
 std::ostream& operator<<(std::ostream& out, Context context);
 
+/// @brief PerfCounter enumerates the perf PMU counters lttng can add as context to events.
+///
+/// Kernel channels record the counters of the cpu an event happened on, userspace
+/// channels record the counters of the thread an event happened on. The counters
+/// actually available depend on the domain and the CPU.
+enum class PerfCounter
+{
+  cpu_cycles,
+  instructions,
+  cache_references,
+  cache_misses,
+  branch_instructions,
+  branch_misses,
+  bus_cycles,
+  stalled_cycles_frontend,
+  stalled_cycles_backend,
+  cpu_clock,
+  task_clock,
+  page_faults,
+  context_switches,
+  cpu_migrations,
+  minor_faults,
+  major_faults
+};
+
+/// @brief operator<< pretty prints the given counter to the given output stream, in lttng's notation, e.g., cpu-cycles.
+std::ostream& operator<<(std::ostream& out, PerfCounter counter);
+
+/// @brief PerfEventConfig identifies a counter to perf_event_open(2).
+struct PerfEventConfig
+{
+  std::uint32_t type; ///< The type of the counter, e.g., PERF_TYPE_HARDWARE.
+  std::uint64_t config; ///< The counter within its type, e.g., PERF_COUNT_HW_CPU_CYCLES.
+};
+
+/// @brief perf_event_config returns the perf_event_open(2) configuration of the given counter.
+PerfEventConfig perf_event_config(PerfCounter counter);
+
+/// @brief perf_field_name returns the name of the context field carrying the given counter in traces of the given domain, e.g., perf_thread_cpu_cycles.
+std::string perf_field_name(Domain domain, PerfCounter counter);
+
 /// @brief Consumer models an arbitrary trace consumer.
 class Consumer : public boost::noncopyable
 {
@@ -131,12 +182,451 @@ class FileSystemConsumer : public Consumer
   boost::filesystem::path path_;
 };
 
+/// @brief Channel configures the ring buffers events are recorded into.
+///
+/// The channel is the main lever over tracing overhead and event loss: larger and more
+/// sub-buffers absorb bursts, overwrite mode never blocks or discards new events, and
+/// timers bound the latency until events are flushed to the consumer.
+struct Channel
+{
+  /// @brief Mode enumerates the behavior of a channel if all sub-buffers are full.
+  enum class Mode
+  {
+    discard, ///< New events are discarded.
+    overwrite ///< The oldest sub-buffer is overwritten.
+  };
+
+  /// @brief Buffers enumerates the ownership of ring buffers.
+  ///
+  /// Ownership is a property of the domain of a session, it is fixed by the first channel enabled in a domain.
+  enum class Buffers
+  {
+    per_uid, ///< Userspace only: one set of buffers per user.
+    per_pid, ///< Userspace only: one set of buffers per process.
+    global ///< Kernel only: a single set of buffers.
+  };
+
+  /// @brief Output enumerates the ways sub-buffers are handed to the consumer.
+  enum class Output
+  {
+    mmap, ///< Sub-buffers are read through a shared memory mapping.
+    splice ///< Kernel only: sub-buffers are spliced to the output.
+  };
+
+  /// @brief defaults returns a channel with the given name, configured like lttng's default channel for the given domain.
+  static Channel defaults(Domain domain, const std::string& name);
+
+  std::string name; ///< The name of the channel.
+  std::uint64_t subbuffer_size; ///< Size of a single sub-buffer in bytes, a power of two.
+  std::uint64_t subbuffer_count; ///< Number of sub-buffers per ring buffer, a power of two.
+  Mode mode; ///< Behavior if all sub-buffers are full.
+  Buffers buffers; ///< Ownership of the ring buffers.
+  Output output; ///< The way sub-buffers are handed to the consumer.
+  std::chrono::microseconds switch_timer; ///< Period of forced sub-buffer switches, 0 to disable.
+  std::chrono::microseconds read_timer; ///< Period of checks for readable sub-buffers, 0 to wake up the consumer instead.
+  boost::optional<std::chrono::microseconds> monitor_timer; ///< Period of buffer usage sampling, lttng's default if not set.
+  std::uint64_t tracefile_size; ///< Maximum size of a single trace file in bytes, 0 for unlimited.
+  std::uint64_t tracefile_count; ///< Maximum number of trace files per stream, 0 for unlimited.
+};
+
+/// @brief LogLevel enumerates the severities of userspace tracepoints, most severe first.
+enum class LogLevel
+{
+  emergency = 0,
+  alert = 1,
+  critical = 2,
+  error = 3,
+  warning = 4,
+  notice = 5,
+  info = 6,
+  debug_system = 7,
+  debug_program = 8,
+  debug_process = 9,
+  debug_module = 10,
+  debug_unit = 11,
+  debug_function = 12,
+  debug_line = 13,
+  debug = 14
+};
+
+/// @brief operator<< pretty prints the given log level to the given output stream, in lttng's notation, e.g., TRACE_WARNING.
+std::ostream& operator<<(std::ostream& out, LogLevel level);
+
+/// @brief EventRule describes the events to enable, filtered by the tracer before they reach the ring buffer.
+///
+///   lttng::EventRule rule{lttng::events::userspace::libc::malloc};
+///   rule.filter = "size > 4096 && $ctx.vpid == 42";
+struct EventRule
+{
+  /// @brief LogLevelMatch enumerates the ways events are matched by their log level.
+  enum class LogLevelMatch
+  {
+    all, ///< Events of all log levels match.
+    range, ///< Events of the given log level or more severe match.
+    single ///< Only events of exactly the given log level match.
+  };
+
+  /// @brief EventRule creates a rule matching all events with the given name, which may end in a wildcard.
+  explicit EventRule(const std::string& name);
+
+  std::string name; ///< The name of the events, possibly ending in a wildcard.
+  std::string filter; ///< The filter expression evaluated by the tracer, empty if events are not filtered.
+  LogLevelMatch log_level_match; ///< Userspace only: the way events are matched by their log level.
+  LogLevel log_level; ///< Userspace only: the log level matched against, unless log_level_match is all.
+  std::vector<std::string> exclusions; ///< Userspace only: names of events excluded from a wildcard name.
+};
+
+/// @brief operator<< pretty prints the given log level match to the given output stream.
+std::ostream& operator<<(std::ostream& out, EventRule::LogLevelMatch match);
+
+/// @brief operator<< pretty prints the given channel mode to the given output stream.
+std::ostream& operator<<(std::ostream& out, Channel::Mode mode);
+
+/// @brief operator<< pretty prints the given buffer ownership to the given output stream.
+std::ostream& operator<<(std::ostream& out, Channel::Buffers buffers);
+
+/// @brief operator<< pretty prints the given channel output to the given output stream.
+std::ostream& operator<<(std::ostream& out, Channel::Output output);
+
+/// @brief SessionMode enumerates the ways a session records events.
+enum class SessionMode
+{
+  regular, ///< Events are continuously handed to the consumer.
+  snapshot ///< Events are kept in overwrite-mode buffers in memory, and only written by explicitly recording a snapshot.
+};
+
+/// @brief operator<< pretty prints the given session mode to the given output stream.
+std::ostream& operator<<(std::ostream& out, SessionMode mode);
+
+/// @brief RotationSchedule describes when lttng automatically archives the trace chunk recorded so far.
+///
+/// If both conditions are set, a rotation happens whenever either of them is met.
+struct RotationSchedule
+{
+  /// @brief every returns a schedule rotating periodically, with the given period.
+  static RotationSchedule every(std::chrono::microseconds period);
+
+  /// @brief larger_than returns a schedule rotating whenever the current chunk exceeds the given size in bytes.
+  static RotationSchedule larger_than(std::uint64_t size);
+
+  boost::optional<std::chrono::microseconds> period; ///< Period of rotations, if set.
+  boost::optional<std::uint64_t> size; ///< Size of a chunk in bytes that triggers a rotation, if set.
+};
+
+/// @brief Command enumerates the operations a ControlBackend carries out.
+enum class Command
+{
+  create_session,
+  create_snapshot_session,
+  destroy_session,
+  enable_channel,
+  add_context,
+  enable_event,
+  start,
+  stop,
+  record_snapshot,
+  load_session,
+  rotate,
+  enable_rotation,
+  disable_rotation
+};
+
+/// @brief operator<< pretty prints the given command to the given output stream.
+std::ostream& operator<<(std::ostream& out, Command command);
+
+/// @brief CommandMetrics counts the invocations of a single command and their latency.
+struct CommandMetrics
+{
+  std::uint64_t calls{0}; ///< Number of invocations, including failed ones.
+  std::uint64_t failures{0}; ///< Number of invocations that threw.
+  std::chrono::nanoseconds total{0}; ///< Wall-clock time spent in all invocations.
+  Histogram latency; ///< Distribution of the wall-clock time of individual invocations.
+};
+
+/// @brief ControlBackend abstracts the way sessions are controlled on the session daemon.
+///
+/// Every backend counts its commands and measures their latency, see metrics().
+/// Implementations override the protected do_* functions.
+class ControlBackend : public boost::noncopyable
+{
+ public:
+  /// @brief Metrics maps every invoked command to its metrics.
+  typedef std::map<Command, CommandMetrics> Metrics;
+
+  /// @brief exec returns a backend running the lttng command line client at the given path for every operation.
+  static std::shared_ptr<ControlBackend> exec(const boost::filesystem::path& lttng = boost::filesystem::path{"/usr/bin/lttng"});
+
+  /// @brief lttng_ctl returns a backend talking to the session daemon in-process, through liblttng-ctl.
+  ///
+  /// Requires liblttng-ctl 2.10 or later at build time. Rotation commands throw unless built against 2.11 or later.
+  ///
+  /// liblttng-ctl keeps its connection to the session daemon in global state, calls into it are
+  /// thus serialized across all sessions and backends. Only the exec backend runs commands concurrently.
+  /// @throws std::runtime_error if the library has been built without liblttng-ctl.
+  static std::shared_ptr<ControlBackend> lttng_ctl();
+
+  /// @brief default_backend returns the liblttng-ctl backend if available, the exec backend otherwise.
+  static std::shared_ptr<ControlBackend> default_backend();
+
+  virtual ~ControlBackend() = default;
+
+  /// @brief create_session creates a session with the given name, recording to the given url.
+  /// @throws std::runtime_error in case of issues.
+  void create_session(const std::string& name, const std::string& url);
+
+  /// @brief create_snapshot_session creates a snapshot session with the given name, recording snapshots to the given url by default.
+  /// @throws std::runtime_error in case of issues.
+  void create_snapshot_session(const std::string& name, const std::string& url);
+
+  /// @brief destroy_session destroys the session with the given name.
+  /// @throws std::runtime_error in case of issues.
+  void destroy_session(const std::string& name);
+
+  /// @brief enable_channel creates and enables the given channel in the given domain of the session with the given name.
+  /// @throws std::runtime_error in case of issues.
+  void enable_channel(const std::string& session, Domain domain, const Channel& channel);
+
+  /// @brief add_context adds the given context to the channel with the given name in the given domain of the session with the given name.
+  ///
+  /// An empty channel name refers to all channels of the domain.
+  /// @throws std::runtime_error in case of issues.
+  void add_context(const std::string& session, Domain domain, const std::string& channel, Context context);
+
+  /// @brief add_context adds the given perf counter to the channel with the given name in the given domain of the session with the given name.
+  ///
+  /// An empty channel name refers to all channels of the domain. Accounted for as Command::add_context.
+  /// @throws std::runtime_error in case of issues.
+  void add_context(const std::string& session, Domain domain, const std::string& channel, PerfCounter counter);
+
+  /// @brief enable_event enables the events matching the given rule in the channel with the given name in the given domain of the session with the given name.
+  ///
+  /// An empty channel name refers to lttng's default channel, which is created if necessary.
+  /// @throws std::runtime_error in case of issues.
+  void enable_event(const std::string& session, Domain domain, const std::string& channel, const EventRule& rule);
+
+  /// @brief start starts tracing in the session with the given name.
+  /// @throws std::runtime_error in case of issues.
+  void start(const std::string& session);
+
+  /// @brief stop stops tracing in the session with the given name, waiting for all data to be consumed.
+  /// @throws std::runtime_error in case of issues.
+  void stop(const std::string& session);
+
+  /// @brief record_snapshot writes the current buffers of the snapshot session with the given name to the given url.
+  ///
+  /// The snapshot is written to a directory below url, named after the given snapshot name.
+  /// @throws std::runtime_error in case of issues.
+  void record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url);
+
+  /// @brief load_session creates the session with the given name from the session description in the given file.
+  /// @throws std::runtime_error in case of issues.
+  void load_session(const std::string& name, const boost::filesystem::path& file);
+
+  /// @brief rotate archives the trace chunk recorded so far by the session with the given name, waiting for the archive to complete.
+  ///
+  /// The chunk is moved to a directory below archives/ in the output of the session.
+  /// @throws std::runtime_error in case of issues.
+  void rotate(const std::string& session);
+
+  /// @brief enable_rotation makes lttng rotate the session with the given name according to the given schedule.
+  /// @throws std::runtime_error in case of issues.
+  void enable_rotation(const std::string& session, const RotationSchedule& schedule);
+
+  /// @brief disable_rotation removes the given schedule, previously enabled with enable_rotation, from the session with the given name.
+  /// @throws std::runtime_error in case of issues.
+  void disable_rotation(const std::string& session, const RotationSchedule& schedule);
+
+  /// @brief metrics returns a snapshot of the metrics of all commands invoked so far.
+  Metrics metrics() const;
+
+  /// @brief reset_metrics clears the metrics of all commands.
+  void reset_metrics();
+
+ protected:
+  // Only subclasses can instantiate.
+  ControlBackend() = default;
+
+  virtual void do_create_session(const std::string& name, const std::string& url) = 0;
+  virtual void do_create_snapshot_session(const std::string& name, const std::string& url) = 0;
+  virtual void do_destroy_session(const std::string& name) = 0;
+  virtual void do_enable_channel(const std::string& session, Domain domain, const Channel& channel) = 0;
+  virtual void do_add_context(const std::string& session, Domain domain, const std::string& channel, Context context) = 0;
+  virtual void do_add_perf_context(const std::string& session, Domain domain, const std::string& channel, PerfCounter counter) = 0;
+  virtual void do_enable_event(const std::string& session, Domain domain, const std::string& channel, const EventRule& rule) = 0;
+  virtual void do_start(const std::string& session) = 0;
+  virtual void do_stop(const std::string& session) = 0;
+  virtual void do_record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url) = 0;
+  virtual void do_load_session(const std::string& name, const boost::filesystem::path& file) = 0;
+  virtual void do_rotate(const std::string& session) = 0;
+  virtual void do_enable_rotation(const std::string& session, const RotationSchedule& schedule) = 0;
+  virtual void do_disable_rotation(const std::string& session, const RotationSchedule& schedule) = 0;
+
+ private:
+  // Invokes f, accounting for it in the metrics of the given command.
+  void measure(Command command, const std::function<void()>& f);
+
+  mutable std::mutex guard;
+  Metrics metrics_;
+};
+
+/// @brief RecordingControlBackend implements ControlBackend without talking to a session daemon.
+///
+/// All commands are recorded, such that tests can verify the commands issued by
+/// Session and Tracer without requiring a session daemon or root privileges.
+class RecordingControlBackend : public ControlBackend
+{
+ public:
+  /// @brief Call describes a single recorded command.
+  struct Call
+  {
+    Command command; ///< The command.
+    std::string session; ///< The name of the session the command targets.
+    std::vector<std::string> arguments; ///< The remaining arguments, rendered as strings.
+  };
+
+  /// @brief calls returns all commands recorded so far, in order.
+  std::vector<Call> calls() const;
+
+  /// @brief fail makes all subsequent invocations of the given command throw lttng::Exception with the given code.
+  void fail(Command command, int code);
+
+ protected:
+  void do_create_session(const std::string& name, const std::string& url) override;
+  void do_create_snapshot_session(const std::string& name, const std::string& url) override;
+  void do_destroy_session(const std::string& name) override;
+  void do_enable_channel(const std::string& session, Domain domain, const Channel& channel) override;
+  void do_add_context(const std::string& session, Domain domain, const std::string& channel, Context context) override;
+  void do_add_perf_context(const std::string& session, Domain domain, const std::string& channel, PerfCounter counter) override;
+  void do_enable_event(const std::string& session, Domain domain, const std::string& channel, const EventRule& rule) override;
+  void do_start(const std::string& session) override;
+  void do_stop(const std::string& session) override;
+  void do_record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url) override;
+  void do_load_session(const std::string& name, const boost::filesystem::path& file) override;
+  void do_rotate(const std::string& session) override;
+  void do_enable_rotation(const std::string& session, const RotationSchedule& schedule) override;
+  void do_disable_rotation(const std::string& session, const RotationSchedule& schedule) override;
+
+ private:
+  // Records the given call, throwing if the command has been told to fail.
+  void record(const Call& call);
+
+  mutable std::mutex guard;
+  std::vector<Call> calls_;
+  std::map<Command, int> failures;
+  std::map<std::string, std::string> urls; ///< Urls of created sessions, by name.
+};
+
+/// @brief SessionConfig describes a complete tracing session, such that it can be set up in a single step.
+///
+/// Contexts and events are added to the channel most recently selected with channel(),
+/// or to lttng's default channel if no channel has been selected:
+///
+///   lttng::SessionConfig config{lttng::Domain::userspace, "malloc", consumer};
+///   config.add_context(lttng::Context::vpid).enable_event(lttng::events::userspace::libc::malloc, "size > 4096");
+///   auto session = tracer->create_session(config);
+class SessionConfig
+{
+ public:
+  /// @brief default_channel is the name of the channel lttng creates if none is given.
+  static constexpr const char* default_channel{"channel0"};
+
+  /// @brief ChannelConfig describes a channel together with its contexts and events.
+  struct ChannelConfig
+  {
+    Channel channel; ///< The configuration of the channel.
+    std::vector<Context> contexts; ///< Contexts added to all events of the channel.
+    std::vector<PerfCounter> perf_counters; ///< Perf counters added to all events of the channel.
+    std::vector<EventRule> events; ///< Events enabled in the channel.
+  };
+
+  /// @brief load reads a configuration previously written by save.
+  /// @throws std::runtime_error if the file cannot be read or is not a valid session description.
+  static SessionConfig load(const boost::filesystem::path& path);
+
+  /// @brief SessionConfig creates an empty configuration for the session with the given name in the given domain.
+  SessionConfig(Domain domain, const std::string& name, const std::shared_ptr<Consumer>& consumer);
+
+  /// @brief channel selects the channel with the given name, creating it with default settings if necessary.
+  SessionConfig& channel(const std::string& name);
+
+  /// @brief channel selects the given channel, creating it if necessary, and replaces its settings.
+  SessionConfig& channel(const Channel& channel);
+
+  /// @brief add_context adds the given context to the current channel.
+  SessionConfig& add_context(Context context);
+
+  /// @brief add_context adds the given perf counter to the current channel.
+  SessionConfig& add_context(PerfCounter counter);
+
+  /// @brief enable_event enables the event with the given name in the current channel, filtered by the given expression.
+  SessionConfig& enable_event(const std::string& event, const std::string& filter = std::string{});
+
+  /// @brief enable_event enables the events matching the given rule in the current channel.
+  SessionConfig& enable_event(const EventRule& rule);
+
+  /// @brief domain returns the domain of the session.
+  Domain domain() const;
+
+  /// @brief name returns the name of the session.
+  const std::string& name() const;
+
+  /// @brief consumer returns the consumer of the session.
+  const std::shared_ptr<Consumer>& consumer() const;
+
+  /// @brief channels returns all channels of the session.
+  const std::vector<ChannelConfig>& channels() const;
+
+  /// @brief to_xml renders the configuration as an lttng session description, as understood by lttng load.
+  std::string to_xml() const;
+
+  /// @brief save writes the configuration to the given file, in the format returned by to_xml.
+  /// @throws std::runtime_error if the file cannot be written.
+  void save(const boost::filesystem::path& path) const;
+
+ private:
+  // Returns the current channel, selecting the default channel if none has been selected.
+  ChannelConfig& current();
+
+  Domain domain_;
+  std::string name_;
+  std::shared_ptr<Consumer> consumer_;
+  std::vector<ChannelConfig> channels_;
+  std::size_t current_;
+};
+
 /// @brief Session models an individual tracing session.
+///
+/// Asynchronous operations run on a thread of their own. They only refer to the name and
+/// the backend of the session, such that they are safe to outlive the instance they were started from.
 class Session : public boost::noncopyable
 {
  public:
-  /// @brief Creates a new session with the given name.
-  Session(Domain domain, const std::string& name, const std::shared_ptr<Consumer>& consumer);
+  /// @brief CompletionHandler is invoked on completion of an asynchronous operation, with a null exception_ptr on success.
+  typedef std::function<void(std::exception_ptr)> CompletionHandler;
+
+  /// @brief ChunkHandler is invoked for every archived trace chunk, with the opened chunk and its directory.
+  typedef std::function<void(ctf::Trace& chunk, const boost::filesystem::path& directory)> ChunkHandler;
+
+  /// @brief Creates a new session with the given name, controlled through the given backend.
+  Session(
+      Domain domain,
+      const std::string& name,
+      const std::shared_ptr<Consumer>& consumer,
+      const std::shared_ptr<ControlBackend>& backend = ControlBackend::default_backend());
+
+  /// @brief Creates a new session with the given name in the given mode, controlled through the given backend.
+  ///
+  /// Snapshot sessions record snapshots to consumer by default. Channels enabled in
+  /// snapshot sessions must be in overwrite mode, lttng's default channel is.
+  Session(
+      Domain domain,
+      const std::string& name,
+      const std::shared_ptr<Consumer>& consumer,
+      SessionMode mode,
+      const std::shared_ptr<ControlBackend>& backend = ControlBackend::default_backend());
+
+  /// @brief Creates a new session from the given configuration in a single step, controlled through the given backend.
+  Session(const SessionConfig& config, const std::shared_ptr<ControlBackend>& backend = ControlBackend::default_backend());
 
   /// @brief ~Session stops the tracing session.
   virtual ~Session();
@@ -144,34 +634,135 @@ class Session : public boost::noncopyable
   /// @brief name returns the name of the session.
   virtual const std::string& name() const;
 
+  /// @brief mode returns the mode of the session.
+  virtual SessionMode mode() const;
+
+  /// @brief enable_channel creates and enables the given channel in this session.
+  /// @throws std::runtime_error in case of issues.
+  virtual void enable_channel(const Channel& channel);
+
   /// @brief add_context enables the given context for all enabled events in this session.
   virtual void add_context(Context ctxt);
 
+  /// @brief add_context enables the given context for all events in the channel with the given name.
+  /// @throws std::runtime_error in case of issues.
+  virtual void add_context(Context ctxt, const std::string& channel);
+
+  /// @brief add_context adds the given perf counter to all events in the channel with the given name.
+  ///
+  /// An empty channel name refers to all channels. Traces carry the counter in the
+  /// field named perf_field_name(domain, counter) of the stream event context.
+  /// @throws std::runtime_error in case of issues.
+  virtual void add_context(PerfCounter counter, const std::string& channel = std::string{});
+
   /// @brief enable_event enables the event with the given name in the given domain.
   /// @throws std::runtime_error in case of issues.
   virtual void enable_event(const std::string& event);
 
+  /// @brief enable_event enables the event with the given name in the channel with the given name.
+  /// @throws std::runtime_error in case of issues.
+  virtual void enable_event(const std::string& event, const std::string& channel);
+
+  /// @brief enable_event enables the events matching the given rule in the channel with the given name.
+  ///
+  /// An empty channel name refers to lttng's default channel.
+  /// @throws std::runtime_error in case of issues.
+  virtual void enable_event(const EventRule& rule, const std::string& channel = std::string{});
+
   /// @brief Starts the tracing.
   virtual void start();
 
   /// @brief Stops the tracing.
   virtual void stop();
 
+  /// @brief record_snapshot writes the current buffers of this snapshot session to the consumer of the session.
+  /// @returns the directory the snapshot has been written to, ready to be opened with ctf::Trace.
+  /// @throws std::runtime_error if this is not a snapshot session, its consumer is not a FileSystemConsumer or in case of issues.
+  virtual boost::filesystem::path record_snapshot();
+
+  /// @brief record_snapshot writes the current buffers of this snapshot session to the given consumer.
+  /// @returns the directory the snapshot has been written to, ready to be opened with ctf::Trace.
+  /// @throws std::runtime_error if this is not a snapshot session or in case of issues.
+  virtual boost::filesystem::path record_snapshot(const std::shared_ptr<FileSystemConsumer>& consumer);
+
+  /// @brief rotate archives the trace chunk recorded so far, while tracing continues into a new chunk.
+  ///
+  /// Rotating a stopped session archives the remainder of the trace. The returned chunk is handed
+  /// to a handler installed with on_chunk, too, but never removed by it.
+  /// @returns the directory the chunk has been archived to, ready to be opened with ctf::Trace.
+  /// @throws std::runtime_error if this is not a regular session, its consumer is not a FileSystemConsumer or in case of issues.
+  virtual boost::filesystem::path rotate();
+
+  /// @brief enable_rotation makes lttng rotate this session automatically, according to the given schedule.
+  ///
+  /// Replaces a previously enabled schedule.
+  /// @throws std::runtime_error if the schedule sets neither period nor size or in case of issues.
+  virtual void enable_rotation(const RotationSchedule& schedule);
+
+  /// @brief disable_rotation stops automatic rotations of this session, if enabled.
+  /// @throws std::runtime_error in case of issues.
+  virtual void disable_rotation();
+
+  /// @brief on_chunk invokes handler on a thread of its own for every chunk archived by rotations of this session.
+  ///
+  /// Chunks are handed over in the order they have been recorded, such that analysis overlaps
+  /// recording. Chunks that have been handled without throwing are removed from disk if
+  /// remove_handled is true, keeping disk usage bounded, except for the ones returned by rotate().
+  /// Errors accessing the archive directory are retried on the next check. The archive directory is checked for
+  /// new chunks every poll_interval. Replaces a previously installed handler. Watching stops on
+  /// destruction of the session, after handing over pending chunks: call rotate() after stop()
+  /// to archive the final chunk.
+  /// @throws std::runtime_error if the consumer of the session is not a FileSystemConsumer.
+  virtual void on_chunk(
+      const ChunkHandler& handler,
+      bool remove_handled = false,
+      std::chrono::milliseconds poll_interval = std::chrono::milliseconds{500});
+
+  /// @brief async_start starts the tracing without blocking the calling thread.
+  /// @returns a future that becomes ready once tracing has been started, carrying an exception in case of issues.
+  virtual std::future<void> async_start();
+
+  /// @brief async_start starts the tracing without blocking the calling thread, posting handler to io_service on completion.
+  virtual void async_start(boost::asio::io_service& io_service, const CompletionHandler& handler);
+
+  /// @brief async_stop stops the tracing without blocking the calling thread.
+  /// @returns a future that becomes ready once tracing has been stopped, carrying an exception in case of issues.
+  virtual std::future<void> async_stop();
+
+  /// @brief async_stop stops the tracing without blocking the calling thread, posting handler to io_service on completion.
+  virtual void async_stop(boost::asio::io_service& io_service, const CompletionHandler& handler);
+
  private:
   Domain domain_; ///< The domain of the tracing session.
   std::string name_; ///< The name of the tracing session.
+  SessionMode mode_; ///< The mode of the tracing session.
   std::shared_ptr<Consumer> consumer_; ///< The trace consumer instance.
+  std::shared_ptr<ControlBackend> backend_; ///< The backend controlling the session.
+  std::uint64_t snapshots_; ///< The number of snapshots recorded so far.
+  boost::optional<RotationSchedule> rotation_; ///< The schedule of automatic rotations, if enabled.
+
+  class ChunkWatcher;
+  std::unique_ptr<ChunkWatcher> chunk_watcher_; ///< Hands archived chunks to the chunk handler, if installed.
 };
 
 /// Tracer is the primary point of entry to the lttng-tracing functionality.
+///
+/// Sessions created asynchronously are set up on a thread of their own each, without blocking the caller.
+/// Whether their commands overlap depends on the ControlBackend: the exec backend runs them concurrently,
+/// the liblttng-ctl backend serializes them.
 class Tracer
 {
  public:
-  /// @brief create returns a new unique tracer instance.
-  static std::unique_ptr<Tracer> create(Domain domain);
+  /// @brief SessionHandler is invoked on completion of an asynchronous session creation.
+  ///
+  /// On success, the exception_ptr is null and the session is valid. Otherwise, the session is null.
+  typedef std::function<void(std::exception_ptr, std::shared_ptr<Session>)> SessionHandler;
+
+  /// @brief create returns a new unique tracer instance, controlling sessions through the given backend.
+  static std::unique_ptr<Tracer> create(Domain domain, const std::shared_ptr<ControlBackend>& backend = ControlBackend::default_backend());
 
-  /// @brief Tracer creates a new tracer instance.
-  Tracer(Domain domain);
+  /// @brief Tracer creates a new tracer instance, controlling sessions through the given backend.
+  Tracer(Domain domain, const std::shared_ptr<ControlBackend>& backend = ControlBackend::default_backend());
 
   /// @brief ~Tracer cleans up and disables all lttng tracing functionality.
   virtual ~Tracer() = default;
@@ -179,8 +770,33 @@ class Tracer
   /// @brief create_session creates a new tracing session with the given name and the given consumer.
   virtual std::shared_ptr<Session> create_session(const std::string& name, const std::shared_ptr<Consumer>& consumer);
 
+  /// @brief create_session creates a new tracing session with the given name and the given consumer, in the given mode.
+  virtual std::shared_ptr<Session> create_session(const std::string& name, const std::shared_ptr<Consumer>& consumer, SessionMode mode);
+
+  /// @brief create_session creates a new tracing session from the given configuration in a single step.
+  /// @throws std::runtime_error if the configuration targets a different domain than the tracer.
+  virtual std::shared_ptr<Session> create_session(const SessionConfig& config);
+
+  /// @brief async_create_session creates a new tracing session without blocking the calling thread.
+  virtual std::future<std::shared_ptr<Session>> async_create_session(const std::string& name, const std::shared_ptr<Consumer>& consumer);
+
+  /// @brief async_create_session creates a new tracing session without blocking the calling thread, posting handler to io_service on completion.
+  virtual void async_create_session(
+      boost::asio::io_service& io_service,
+      const std::string& name,
+      const std::shared_ptr<Consumer>& consumer,
+      const SessionHandler& handler);
+
+  /// @brief async_create_session creates a new tracing session from the given configuration without blocking the calling thread.
+  virtual std::future<std::shared_ptr<Session>> async_create_session(const SessionConfig& config);
+
+  /// @brief async_create_session creates a new tracing session from the given configuration without blocking
+  /// the calling thread, posting handler to io_service on completion.
+  virtual void async_create_session(boost::asio::io_service& io_service, const SessionConfig& config, const SessionHandler& handler);
+
  private:
   Domain domain;
+  std::shared_ptr<ControlBackend> backend;
 };
 }
 
@@ -0,0 +1,75 @@
+#ifndef CTF_SYMBOLIZER_H_
+#define CTF_SYMBOLIZER_H_
+
+#include <lttng/ctf.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace ctf
+{
+/// @brief Symbol describes the function or object an address resolved to.
+struct Symbol
+{
+  std::string name; ///< The name of the symbol, as found in the symbol table.
+  std::uint64_t offset; ///< The offset of the address from the start of the symbol.
+  boost::filesystem::path object; ///< The path of the object containing the symbol.
+};
+
+/// @brief Symbolizer resolves instruction pointers recorded in a trace to symbols.
+///
+/// Symbolizer maintains an interval map of the objects loaded into every process,
+/// fed by ust_baddr_statedump:soinfo events. Symbol tables of objects are read
+/// from their ELF files lazily, once per object, and resolved addresses are cached.
+class Symbolizer
+{
+ public:
+  /// @brief Symbolizer creates a new instance, reading objects relative to the given sysroot.
+  explicit Symbolizer(const boost::filesystem::path& sysroot = boost::filesystem::path{"/"});
+  Symbolizer(const Symbolizer&) = delete;
+  ~Symbolizer();
+
+  Symbolizer& operator=(const Symbolizer&) = delete;
+
+  /// @brief add_object records that the object at path is mapped to [base, base + size) in the process with the given vpid.
+  ///
+  /// Previous mappings overlapping the new one are removed.
+  void add_object(std::int64_t vpid, std::uint64_t base, std::uint64_t size, const std::string& path);
+
+  /// @brief on_event records the object described by the given event, if it is a soinfo event.
+  /// @returns true if the event has been recorded.
+  bool on_event(const Event& event);
+
+  /// @brief resolve returns the symbol containing the given address in the process with the given vpid.
+  ///
+  /// The returned symbol remains valid for the lifetime of this instance.
+  /// @returns nullptr if the address cannot be resolved.
+  const Symbol* resolve(std::int64_t vpid, std::uint64_t address);
+
+  /// @brief resolve returns the symbol containing the ip context of the given event.
+  ///
+  /// Also records the event with on_event, such that a trace can be symbolized in a single pass.
+  /// @returns nullptr if the event lacks vpid or ip contexts, or the ip cannot be resolved.
+  const Symbol* resolve(const Event& event);
+
+ private:
+  class Object;
+
+  // Mapping describes the range of addresses an object is mapped to in a process.
+  struct Mapping
+  {
+    std::uint64_t end;
+    Object* object;
+  };
+
+  boost::filesystem::path sysroot;
+  std::map<std::string, std::unique_ptr<Object>> objects; ///< All objects, by path.
+  std::map<std::int64_t, std::map<std::uint64_t, Mapping>> processes; ///< Mappings per vpid, keyed by start address.
+};
+}
+
+#endif // CTF_SYMBOLIZER_H_
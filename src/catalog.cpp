@@ -0,0 +1,176 @@
+#include <lttng/catalog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+constexpr const char* metadata{"metadata"};
+
+// Returns an entry for the given directory, reporting the given error.
+ctf::TraceCatalog::Entry errored(const boost::filesystem::path& dir, const std::string& what, const boost::system::error_code& ec)
+{
+  return ctf::TraceCatalog::Entry
+  {
+    dir, 0, 0, std::vector<boost::filesystem::path>{}, 0,
+    std::make_exception_ptr(boost::filesystem::filesystem_error("TraceCatalog: could not " + what, dir, ec))
+  };
+}
+
+// Describes the trace in the given directory, which is known to contain a metadata file.
+// Stream files vanishing while describing the trace are left out.
+ctf::TraceCatalog::Entry describe(const boost::filesystem::path& dir)
+{
+  boost::system::error_code ec;
+  ctf::TraceCatalog::Entry entry
+  {
+    dir, 0, 0, std::vector<boost::filesystem::path>{}, 0, nullptr
+  };
+
+  entry.metadata_size = boost::filesystem::file_size(dir / metadata, ec);
+  if (not ec)
+    entry.metadata_last_write_time = boost::filesystem::last_write_time(dir / metadata, ec);
+  if (ec)
+    return errored(dir, "read metadata", ec);
+
+  boost::filesystem::directory_iterator it(dir, ec), itE;
+
+  for (; not ec && it != itE; it.increment(ec))
+  {
+    auto name = it->path().filename().string();
+
+    if (name == metadata || name.empty() || name[0] == '.')
+      continue;
+
+    boost::system::error_code stream_ec;
+
+    if (not boost::filesystem::is_regular_file(it->status(stream_ec)))
+      continue;
+
+    auto size = boost::filesystem::file_size(it->path(), stream_ec);
+
+    if (stream_ec == boost::system::errc::no_such_file_or_directory)
+      continue;
+
+    if (stream_ec)
+      return errored(dir, "read stream " + it->path().filename().string(), stream_ec);
+
+    entry.streams.push_back(it->path());
+    entry.bytes += size;
+  }
+
+  if (ec)
+    return errored(dir, "list streams", ec);
+
+  std::sort(entry.streams.begin(), entry.streams.end());
+  return entry;
+}
+
+// Walks the tree below dir, collecting the directories of all traces into traces. Traces are not descended into.
+// Directories that cannot be read are reported as errored entries, except for the root.
+void scan(const boost::filesystem::path& dir, std::vector<boost::filesystem::path>& traces, std::vector<ctf::TraceCatalog::Entry>& entries, bool root)
+{
+  boost::system::error_code ec;
+
+  if (boost::filesystem::is_regular_file(dir / metadata, ec))
+  {
+    traces.push_back(dir);
+    return;
+  }
+
+  boost::filesystem::directory_iterator it(dir, ec), itE;
+
+  if (ec && root)
+    throw boost::filesystem::filesystem_error("TraceCatalog: could not read root directory", dir, ec);
+
+  for (; not ec && it != itE; it.increment(ec))
+  {
+    boost::system::error_code status_ec;
+
+    if (boost::filesystem::is_directory(it->symlink_status(status_ec)))
+      scan(it->path(), traces, entries, false);
+  }
+
+  // Directories vanishing while scanning simply do not contain traces.
+  if (ec && ec != boost::system::errc::no_such_file_or_directory)
+    entries.push_back(errored(dir, "search directory", ec));
+}
+
+// Invokes the given task for every index in [0, count) on at most threads workers.
+// The task must not throw.
+void for_each_index(std::size_t count, const std::function<void(std::size_t)>& task, unsigned int threads)
+{
+  if (count == 0)
+    return;
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<std::size_t>(threads, count);
+
+  // Workers pick indices until all of them have been processed.
+  std::atomic<std::size_t> next{0};
+
+  auto worker = [&]()
+  {
+    for (auto i = next++; i < count; i = next++)
+      task(i);
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; i++)
+    workers.emplace_back(worker);
+
+  worker();
+
+  for (auto& w : workers)
+    w.join();
+}
+}
+
+ctf::TraceCatalog::TraceCatalog(const boost::filesystem::path& root, unsigned int threads)
+    : root_(root),
+      threads_(threads)
+{
+  rescan();
+}
+
+const boost::filesystem::path& ctf::TraceCatalog::root() const
+{
+  return root_;
+}
+
+const std::vector<ctf::TraceCatalog::Entry>& ctf::TraceCatalog::entries() const
+{
+  return entries_;
+}
+
+void ctf::TraceCatalog::rescan()
+{
+  std::vector<boost::filesystem::path> traces;
+  std::vector<Entry> entries;
+  scan(root_, traces, entries, true);
+
+  // Describing traces only touches the file system, and is safe to do concurrently.
+  auto offset = entries.size();
+  entries.resize(offset + traces.size());
+
+  for_each_index(traces.size(), [&](std::size_t i)
+  {
+    try
+    {
+      entries[offset + i] = describe(traces[i]);
+    }
+    catch (...)
+    {
+      entries[offset + i] = Entry{traces[i], 0, 0, std::vector<boost::filesystem::path>{}, 0, std::current_exception()};
+    }
+  }, threads_);
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs)
+  {
+    return lhs.path < rhs.path;
+  });
+
+  entries_.swap(entries);
+}
@@ -0,0 +1,124 @@
+#include <lttng/counters.h>
+
+namespace
+{
+// Returns the integer field with the given name in the stream event context, nullptr if not present.
+const ctf::Integer* integer_context(const ctf::Event& event, const std::string& name)
+{
+  auto it = event.fields.find(std::make_tuple(ctf::Scope::stream_event_context, name));
+
+  if (it == event.fields.end() || it->second.type() != ctf::Field::integer)
+    return nullptr;
+
+  return &it->second.as_integer();
+}
+}
+
+double ctf::CounterTotals::ratio(const std::string& numerator, const std::string& denominator) const
+{
+  auto n = counters.find(numerator);
+  auto d = counters.find(denominator);
+
+  if (n == counters.end() || d == counters.end() || d->second == 0)
+    return 0;
+
+  return static_cast<double>(n->second) / d->second;
+}
+
+double ctf::CounterTotals::per_pair(const std::string& counter) const
+{
+  auto it = counters.find(counter);
+
+  if (it == counters.end() || pairs == 0)
+    return 0;
+
+  return static_cast<double>(it->second) / pairs;
+}
+
+ctf::CounterDeltas::CounterDeltas(
+    const std::string& begin,
+    const std::string& end,
+    const std::vector<std::string>& counters,
+    const ctf::CounterDeltas::Handler& handler)
+    : begin(begin),
+      end(end),
+      counters(counters),
+      handler(handler)
+{
+}
+
+bool ctf::CounterDeltas::on_event(const ctf::Event& event)
+{
+  if (event.name != begin && event.name != end)
+    return false;
+
+  auto context = integer_context(event, "vtid");
+  if (not context)
+    context = integer_context(event, "tid");
+  if (not context)
+    return false;
+
+  auto tid = context->is_signed() ? context->as_int64() : static_cast<std::int64_t>(context->as_uint64());
+
+  if (event.name == begin)
+  {
+    samples[tid].push_back(Sample{event.timestamp, read(event)});
+    return true;
+  }
+
+  auto it = samples.find(tid);
+  if (it == samples.end())
+    return false;
+
+  auto sample = std::move(it->second.back());
+  it->second.pop_back();
+  if (it->second.empty())
+    samples.erase(it);
+
+  ctf::CounterDelta delta{tid, sample.timestamp, event.timestamp - sample.timestamp, {}};
+
+  // Counters missing from either event, or that went backwards, e.g., after a
+  // migration to another cpu, are left out.
+  for (const auto& pair : read(event))
+  {
+    auto before = sample.counters.find(pair.first);
+    if (before != sample.counters.end() && before->second <= pair.second)
+      delta.counters[pair.first] = pair.second - before->second;
+  }
+
+  totals_.pairs++;
+  totals_.duration += delta.duration;
+  for (const auto& pair : delta.counters)
+    totals_.counters[pair.first] += pair.second;
+
+  if (handler)
+    handler(delta);
+
+  return true;
+}
+
+const ctf::CounterTotals& ctf::CounterDeltas::totals() const
+{
+  return totals_;
+}
+
+std::size_t ctf::CounterDeltas::open() const
+{
+  std::size_t result{0};
+
+  for (const auto& pair : samples)
+    result += pair.second.size();
+
+  return result;
+}
+
+std::map<std::string, std::uint64_t> ctf::CounterDeltas::read(const ctf::Event& event) const
+{
+  std::map<std::string, std::uint64_t> result;
+
+  for (const auto& counter : counters)
+    if (auto value = integer_context(event, counter))
+      result[counter] = value->is_signed() ? static_cast<std::uint64_t>(value->as_int64()) : value->as_uint64();
+
+  return result;
+}
@@ -1,6 +1,25 @@
 #include <lttng/ctf.h>
 
+#include <boost/filesystem/fstream.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace
 {
@@ -21,8 +40,472 @@ bt_cb_ret to_c_api(ctf::Trace::EventEnumeratorReply reply)
   throw std::logic_error("to_c_api: we should never reach here.");
 }
 
-// CallbackContext encapsulates handling of event callbacks issued by babeltrace for individual events in a trace.
-struct CallbackContext
+// Reads the unsigned integer field with the given name from the given scope, returning
+// the given default value if the field does not exist.
+std::uint64_t read_uint64_or_default(const bt_ctf_event* event, const bt_definition* scope, const char* name, std::uint64_t dv)
+{
+  if (not scope)
+    return dv;
+
+  auto def = bt_ctf_get_field(event, scope, name);
+  return def ? bt_ctf_get_uint64(def) : dv;
+}
+
+// PacketTracker detects packet boundaries while walking the events of a trace.
+// The packet context definition is owned by its stream, thus its address identifies
+// the stream within a babeltrace context. A change of timestamp_begin in the packet
+// context marks a new packet.
+class PacketTracker
+{
+ public:
+  struct Stream
+  {
+    std::uint64_t timestamp_begin;
+    std::uint64_t packets;
+    bool accepted;
+  };
+
+  // Returns the stream the given event belongs to, and whether the event is the first one of a packet.
+  std::pair<Stream*, bool> track(const bt_ctf_event* event)
+  {
+    auto packet_context = bt_ctf_get_top_level_scope(event, BT_STREAM_PACKET_CONTEXT);
+    auto timestamp_begin = read_uint64_or_default(event, packet_context, "timestamp_begin", 0);
+
+    auto it = streams.find(packet_context);
+
+    if (it == streams.end())
+    {
+      auto& stream = streams[packet_context];
+      stream.timestamp_begin = timestamp_begin;
+      return std::make_pair(&stream, true);
+    }
+
+    if (it->second.timestamp_begin != timestamp_begin)
+    {
+      it->second.timestamp_begin = timestamp_begin;
+      return std::make_pair(&it->second, true);
+    }
+
+    return std::make_pair(&it->second, false);
+  }
+
+  // Forgets all streams. Definitions are owned by a babeltrace context,
+  // and their addresses might be reused once the context is gone.
+  void clear()
+  {
+    streams.clear();
+  }
+
+ private:
+  std::unordered_map<const bt_definition*, Stream> streams;
+};
+
+// EventClasses maps the event declarations of a babeltrace context to per event class
+// values keyed by event name, resolving every declaration's name only once. Values are
+// kept across contexts, declarations only until the context is gone.
+template<typename T>
+class EventClasses
+{
+ public:
+  explicit EventClasses(std::map<std::string, T>& values)
+      : values(values)
+  {
+  }
+
+  // Returns the value of the event class of the given event.
+  T& operator[](const bt_ctf_event* event)
+  {
+    auto decl = bt_ctf_event_get_decl(event);
+    auto it = decls.find(decl);
+
+    if (it == decls.end())
+      it = decls.insert(std::make_pair(decl, &values[bt_ctf_get_decl_event_name(decl)])).first;
+
+    return *it->second;
+  }
+
+  // Forgets all declarations, keeping the values.
+  void clear()
+  {
+    decls.clear();
+  }
+
+ private:
+  // References to values of a std::map stay valid on insertion.
+  std::map<std::string, T>& values;
+  std::unordered_map<const bt_ctf_event_decl*, T*> decls;
+};
+
+// Sampler decides for every event of a trace whether it should be handed out to
+// an enumerator, and keeps track of the effective sampling rates.
+class Sampler
+{
+ public:
+  explicit Sampler(const ctf::Sampling& sampling)
+      : sampling(sampling),
+        rng(sampling.seed),
+        coin(sampling.mode == ctf::Sampling::Mode::bernoulli ? sampling.probability : 1.),
+        report{ctf::SamplingReport::Counters{0, 0}, ctf::SamplingReport::Counters{0, 0}, {}},
+        per_event_class(report.per_event_class)
+  {
+  }
+
+  // Returns true if the given event should be decoded and handed out.
+  bool accept(const bt_ctf_event* event)
+  {
+    report.events.seen++;
+
+    if (sampling.mode == ctf::Sampling::Mode::none)
+    {
+      report.events.delivered++;
+      return true;
+    }
+
+    auto& counters = per_event_class[event];
+    bool accepted{false};
+
+    switch (sampling.mode)
+    {
+      case ctf::Sampling::Mode::none:
+        break;
+      case ctf::Sampling::Mode::every_nth_per_event_class:
+        accepted = counters.seen % sampling.n == 0;
+        break;
+      case ctf::Sampling::Mode::bernoulli:
+        accepted = coin(rng);
+        break;
+      case ctf::Sampling::Mode::packets:
+        accepted = accept_packet_of(event);
+        break;
+    }
+
+    counters.seen++;
+
+    if (accepted)
+    {
+      counters.delivered++;
+      report.events.delivered++;
+    }
+
+    return accepted;
+  }
+
+  // Forgets everything owned by the current babeltrace context, to be invoked before it is released.
+  void leave_context()
+  {
+    per_event_class.clear();
+    packets.clear();
+  }
+
+  // Returns the final report.
+  const ctf::SamplingReport& finish() const
+  {
+    return report;
+  }
+
+ private:
+  bool accept_packet_of(const bt_ctf_event* event)
+  {
+    auto tracked = packets.track(event);
+    auto& stream = *tracked.first;
+
+    if (tracked.second)
+    {
+      stream.accepted = stream.packets % sampling.n == 0;
+      stream.packets++;
+
+      report.packets.seen++;
+      if (stream.accepted)
+        report.packets.delivered++;
+    }
+
+    return stream.accepted;
+  }
+
+  ctf::Sampling sampling;
+  std::mt19937_64 rng;
+  std::bernoulli_distribution coin;
+  ctf::SamplingReport report;
+  EventClasses<ctf::SamplingReport::Counters> per_event_class;
+  PacketTracker packets;
+};
+
+// Recorder keeps track of the instrumentation counters of an iteration.
+class Recorder
+{
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  Recorder(const ctf::Instrumentation& instrumentation, ctf::Statistics& statistics)
+      : instrumentation(instrumentation),
+        statistics(statistics),
+        start(Clock::now()),
+        last_progress(start),
+        per_event_class(statistics.per_event_class)
+  {
+    statistics = ctf::Statistics();
+  }
+
+  // Accounts for the given event, invoked for every event walked by babeltrace.
+  void on_event(const bt_ctf_event* event)
+  {
+    // Checking for progress is done every so many events, keeping clock reads off the hot path.
+    static constexpr const std::uint64_t the_progress_check_interval{1024};
+
+    statistics.events++;
+    per_event_class[event]++;
+
+    auto tracked = packets.track(event);
+
+    if (tracked.second)
+    {
+      auto header = bt_ctf_get_top_level_scope(event, BT_TRACE_PACKET_HEADER);
+      auto packet_context = bt_ctf_get_top_level_scope(event, BT_STREAM_PACKET_CONTEXT);
+
+      auto key = std::make_tuple(
+            read_uint64_or_default(event, header, "stream_id", 0),
+            read_uint64_or_default(event, packet_context, "cpu_id", 0));
+
+      statistics.packets_per_stream[key]++;
+      statistics.bytes += read_uint64_or_default(event, packet_context, "packet_size", 0) / 8;
+    }
+
+    if (instrumentation.on_progress && statistics.events % the_progress_check_interval == 0)
+    {
+      auto now = Clock::now();
+
+      if (now - last_progress >= instrumentation.progress_interval)
+      {
+        last_progress = now;
+        instrumentation.on_progress(finish());
+      }
+    }
+  }
+
+  // Accounts for a decoded event and the time spent on it.
+  void on_decoded(Clock::duration decode_time, Clock::duration enumerator_time)
+  {
+    statistics.decoded_events++;
+    statistics.decode_time += std::chrono::duration_cast<std::chrono::nanoseconds>(decode_time);
+    statistics.enumerator_time += std::chrono::duration_cast<std::chrono::nanoseconds>(enumerator_time);
+  }
+
+  // Forgets everything owned by the current babeltrace context, to be invoked before it is released.
+  void leave_context()
+  {
+    per_event_class.clear();
+    packets.clear();
+  }
+
+  // Updates elapsed time, returning a snapshot of the counters.
+  const ctf::Statistics& finish()
+  {
+    statistics.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    return statistics;
+  }
+
+ private:
+  const ctf::Instrumentation& instrumentation;
+  ctf::Statistics& statistics;
+  Clock::time_point start;
+  Clock::time_point last_progress;
+  EventClasses<std::uint64_t> per_event_class;
+  PacketTracker packets;
+};
+
+// Prefetcher keeps the packets of the streams of a trace that are about to be read
+// in the page cache, and drops the ones that have been read, from a background thread.
+//
+// Packets are located through the lttng packet index of a stream, relating packets
+// to offsets in the stream file and to the range of timestamps they cover. Streams
+// without index are only flagged for sequential access: reading progress cannot be
+// related to offsets in them, and prefetching at a pace of its own would only pull
+// the whole stream into the page cache.
+class Prefetcher
+{
+ public:
+  Prefetcher(const std::vector<boost::filesystem::path>& stream_files, const ctf::Prefetching& prefetching)
+      : prefetching(prefetching),
+        cycles(0),
+        stopped(false)
+  {
+    for (const auto& file : stream_files)
+    {
+      int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+      if (fd < 0)
+        continue;
+
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+      streams.push_back(Stream{fd, read_index(file), 0, 0});
+    }
+
+    bool indexed = std::any_of(streams.begin(), streams.end(), [](const Stream& s) { return not s.packets.empty(); });
+
+    if (indexed)
+      worker = std::thread{[this]() { run(); }};
+  }
+
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+
+  ~Prefetcher()
+  {
+    {
+      std::lock_guard<std::mutex> lg{guard};
+      stopped = true;
+    }
+
+    wakeup.notify_one();
+
+    if (worker.joinable())
+      worker.join();
+
+    for (const auto& stream : streams)
+      ::close(stream.fd);
+  }
+
+  // Announces that reading progressed to the given timestamp, in cycles.
+  void at(std::uint64_t now)
+  {
+    cycles.store(now, std::memory_order_relaxed);
+  }
+
+ private:
+  // Packet is an entry of an lttng packet index.
+  struct Packet
+  {
+    std::uint64_t offset; // In bytes.
+    std::uint64_t size; // In bytes.
+    std::uint64_t timestamp_end; // In cycles.
+  };
+
+  struct Stream
+  {
+    int fd;
+    std::vector<Packet> packets;
+    std::size_t behind; // Packets before this one have been read.
+    std::size_t ahead; // Packets before this one have been prefetched.
+  };
+
+  static std::uint64_t read_be(const unsigned char* p, std::size_t n)
+  {
+    std::uint64_t result{0};
+    for (std::size_t i = 0; i < n; i++)
+      result = (result << 8) | p[i];
+    return result;
+  }
+
+  // Reads the packet index of the given stream file from the index directory next to it.
+  // Returns an empty vector if there is no index or it cannot be interpreted.
+  static std::vector<Packet> read_index(const boost::filesystem::path& file)
+  {
+    static constexpr const std::uint32_t magic{0xC1F1DCC1};
+    static constexpr const std::size_t header_size{16};
+    // offset, packet_size, content_size, timestamp_begin, timestamp_end, events_discarded, stream_id.
+    static constexpr const std::size_t minimum_entry_size{7 * 8};
+
+    std::vector<Packet> result;
+    boost::filesystem::ifstream in{file.parent_path() / "index" / (file.filename().string() + ".idx"), std::ios::binary};
+
+    unsigned char header[header_size];
+    if (not in.read(reinterpret_cast<char*>(header), header_size) || read_be(header, 4) != magic)
+      return result;
+
+    auto entry_size = read_be(header + 12, 4);
+    if (entry_size < minimum_entry_size)
+      return result;
+
+    std::vector<unsigned char> entry(entry_size);
+    while (in.read(reinterpret_cast<char*>(entry.data()), entry.size()))
+      result.push_back(Packet{read_be(&entry[0], 8), read_be(&entry[8], 8) / 8, read_be(&entry[32], 8)});
+
+    return result;
+  }
+
+  void run()
+  {
+    std::unique_lock<std::mutex> ul{guard};
+
+    while (not stopped)
+    {
+      auto now = cycles.load(std::memory_order_relaxed);
+
+      for (auto& stream : streams)
+      {
+        while (stream.behind < stream.packets.size() && stream.packets[stream.behind].timestamp_end < now)
+        {
+          if (prefetching.drop_behind)
+            ::posix_fadvise(stream.fd, stream.packets[stream.behind].offset, stream.packets[stream.behind].size, POSIX_FADV_DONTNEED);
+          stream.behind++;
+        }
+
+        auto until = std::min<std::size_t>(stream.packets.size(), stream.behind + prefetching.packets_ahead);
+
+        for (stream.ahead = std::max(stream.ahead, stream.behind); stream.ahead < until; stream.ahead++)
+          ::posix_fadvise(stream.fd, stream.packets[stream.ahead].offset, stream.packets[stream.ahead].size, POSIX_FADV_WILLNEED);
+      }
+
+      wakeup.wait_for(ul, prefetching.interval);
+    }
+  }
+
+  const ctf::Prefetching prefetching;
+  std::vector<Stream> streams;
+  std::atomic<std::uint64_t> cycles;
+  bool stopped;
+  std::mutex guard;
+  std::condition_variable wakeup;
+  std::thread worker;
+};
+
+// EnumerationLabels resolves values of enumerations to their labels, asking babeltrace
+// only once per declaration and value. Labels are interned and live as long as the process.
+class EnumerationLabels
+{
+ public:
+  // Returns the label of the given value of the enumeration in def/decl.
+  // Throws std::runtime_error if there was an error extracting the label.
+  ctf::StringView resolve(const bt_definition* def, const bt_declaration* decl, std::uint64_t value)
+  {
+    auto& table = tables[decl];
+    auto it = table.find(value);
+
+    if (it != table.end())
+      return it->second;
+
+    auto label = bt_ctf_get_enum_str(def);
+
+    if (bt_ctf_field_get_error() < 0)
+      throw std::runtime_error("Error while interpreting string value of enumeration");
+
+    // Values without a mapping are reported with an empty label.
+    return table[value] = label ? intern(label) : ctf::StringView{};
+  }
+
+  // Forgets all tables. Declarations are owned by a babeltrace context,
+  // and their addresses might be reused once the context is gone.
+  void clear()
+  {
+    tables.clear();
+  }
+
+ private:
+  static ctf::StringView intern(const char* label)
+  {
+    static std::mutex guard;
+    static std::unordered_set<std::string> pool;
+
+    std::lock_guard<std::mutex> lg{guard};
+    return ctf::StringView{*pool.insert(label).first};
+  }
+
+  std::unordered_map<const bt_declaration*, std::unordered_map<std::uint64_t, ctf::StringView>> tables;
+};
+
+// Decoder assembles ctf::Event instances from babeltrace events.
+struct Decoder
 {
   // Tries to extract a ctf::Integer instance from the given def/decl pair.
   // Throws std::runtime_error in case of issues.
@@ -56,15 +539,11 @@ struct CallbackContext
     return result;
   }
 
-  // Tries to extract an enumerator from the given def/decl pair.
+  // Tries to extract an enumerator from the given def/decl pair, resolving its label through the cached tables.
   // Throws std::runtime_error if there was an error extracting the required data.
-  static ctf::Enumerator process_enum_field_value(const bt_ctf_event* event, const bt_definition* def, const bt_declaration*)
+  ctf::Enumerator process_enum_field_value(const bt_ctf_event* event, const bt_definition* def, const bt_declaration* decl)
   {
     ctf::Enumerator result;
-    result.as_string = bt_ctf_get_enum_str(def);
-
-    if (bt_ctf_field_get_error() < 0)
-      throw std::runtime_error("Error while interpreting string value of enumeration");
 
     auto inner_def = bt_ctf_get_enum_int(def);
     auto inner_decl = bt_ctf_get_decl_from_def(inner_def);
@@ -73,25 +552,103 @@ struct CallbackContext
     if (bt_ctf_field_get_error() < 0)
       throw std::runtime_error("Error while interpreting integer value of enumeration");
 
+    auto value = result.as_integer.is_signed() ?
+        static_cast<std::uint64_t>(result.as_integer.as_int64()) :
+        result.as_integer.as_uint64();
+
+    result.as_string = labels.resolve(def, decl, value);
     return result;
   }
 
-  // Tries to extract a std::string from the given def/decl pair.
+  // Tries to extract a view of the string in the given def/decl pair, referring to babeltrace's field buffer.
   // Throws std::runtime_error if there was an error extracting the required data.
-  static std::string process_string_field_value(const bt_ctf_event*, const bt_definition* def, const bt_declaration*)
+  static ctf::StringView process_string_field_value(const bt_ctf_event*, const bt_definition* def, const bt_declaration*)
   {
-    // TODO(tvoss): Make construction safe here.
-    std::string result(bt_ctf_get_string(def));
+    auto result = bt_ctf_get_string(def);
 
-    if (bt_ctf_field_get_error() < 0)
+    if (bt_ctf_field_get_error() < 0 || not result)
       throw std::runtime_error("Error while interpreting string value");
 
+    return ctf::StringView{result};
+  }
+
+  // Tries to extract a view of the characters of the array or sequence in def, up to the first null character.
+  // Returns false if the elements of def are not characters.
+  // Throws std::runtime_error if there was an error extracting the required data.
+  static bool process_char_array_value(bt_definition const* const* defs, unsigned int count, const bt_definition* def, ctf::Field::Variant& result)
+  {
+    if (count == 0)
+      return false;
+
+    auto decl = bt_ctf_get_decl_from_def(defs[0]);
+
+    if (bt_ctf_field_type(decl) != CTF_TYPE_INTEGER || bt_ctf_get_int_len(decl) != 8)
+      return false;
+
+    switch (bt_ctf_get_encoding(decl))
+    {
+      case CTF_STRING_UTF8:
+      case CTF_STRING_ASCII:
+        break;
+      default:
+        return false;
+    }
+
+    auto chars = bt_ctf_get_char_array(def);
+
+    if (bt_ctf_field_get_error() < 0 || not chars)
+      throw std::runtime_error("Error while interpreting characters of array");
+
+    result = ctf::StringView{chars};
+    return true;
+  }
+
+  // Reads the given element definitions into a contiguous buffer, using the given babeltrace accessor.
+  template<typename T, typename U>
+  static std::vector<T> process_elements(bt_definition const* const* defs, unsigned int count, U (*read)(const bt_definition*))
+  {
+    std::vector<T> result(count);
+
+    for (unsigned int i = 0; i < count; i++)
+      result[i] = static_cast<T>(read(defs[i]));
+
+    if (bt_ctf_field_get_error() < 0)
+      throw std::runtime_error("Error while interpreting elements of array");
+
     return result;
   }
 
+  // Tries to decode the given elements of an array or sequence into a contiguous buffer.
+  // Returns false if the elements are neither integers nor floating-point values.
+  static bool process_contiguous_elements(bt_definition const* const* defs, unsigned int count, ctf::Field::Variant& result)
+  {
+    // CTF arrays and sequences are homogeneous, the first element tells us about all of them.
+    if (count == 0)
+      return false;
+
+    auto decl = bt_ctf_get_decl_from_def(defs[0]);
+
+    switch (bt_ctf_field_type(decl))
+    {
+      case CTF_TYPE_INTEGER:
+        if (bt_ctf_get_int_signedness(decl))
+          result = process_elements<std::int64_t>(defs, count, bt_ctf_get_int64);
+        else if (bt_ctf_get_int_len(decl) <= 8)
+          result = process_elements<std::uint8_t>(defs, count, bt_ctf_get_uint64);
+        else
+          result = process_elements<std::uint64_t>(defs, count, bt_ctf_get_uint64);
+        return true;
+      case CTF_TYPE_FLOAT:
+        result = process_elements<double>(defs, count, bt_ctf_get_float);
+        return true;
+      default:
+        return false;
+    }
+  }
+
   // (Recursively) processes the given def/decl pair, returning a ctf::Field::Variant instance containing the resulting values.
   // Throws std::runtime_error in case of issues.
-  static ctf::Field::Variant process_field_value(const bt_ctf_event* event, const bt_definition* def, const bt_declaration* decl)
+  ctf::Field::Variant process_field_value(const bt_ctf_event* event, const bt_definition* def, const bt_declaration* decl)
   {
     auto type = bt_ctf_field_type(decl);
     ctf::Field::Variant result;
@@ -107,7 +664,7 @@ struct CallbackContext
         result = process_float_field_value(event, def, decl);
         break;
       case CTF_TYPE_ENUM:
-        result = process_integer_field_value(event, def, decl);
+        result = process_enum_field_value(event, def, decl);
         break;
       case CTF_TYPE_STRING:
         result = process_string_field_value(event, def, decl);
@@ -140,8 +697,13 @@ struct CallbackContext
           bt_definition const* const* defs(nullptr);
 
           if (bt_ctf_get_field_list(event, def, &defs, &count) == 0)
+          {
+            if (process_char_array_value(defs, count, def, result) || process_contiguous_elements(defs, count, result))
+              break;
+
             for(unsigned int i = 0; i < count; i++, defs++)
               v.push_back(process_field_value(event, *defs, bt_ctf_get_decl_from_def(*defs)));
+          }
 
           result = v;
           break;
@@ -155,7 +717,7 @@ struct CallbackContext
 
   // Assembles a ctf::Field value from the given def instance.
   // Throws std::runtime_error in case of issues.
-  static ctf::Field process_field_definition(const bt_ctf_event* event, const bt_definition* def)
+  ctf::Field process_field_definition(const bt_ctf_event* event, const bt_definition* def)
   {
     auto decl = bt_ctf_get_decl_from_def(def);
     auto type = bt_ctf_field_type(decl);
@@ -163,17 +725,9 @@ struct CallbackContext
     return ctf::Field(bt_ctf_field_name(def), static_cast<ctf::Field::Type>(type), process_field_value(event, def, decl));
   }
 
-  // on_new_event is invoked whenever a new event is visited in a trace,
-  // just dispatches to the member function of the same name.
-  static bt_cb_ret on_new_event(bt_ctf_event* event, void* cookie)
-  {
-    auto thiz = static_cast<CallbackContext*>(cookie);
-    return thiz->on_new_event(event);
-  }
-
-  // on_new_event is invoked whenever a new event is visited in a trace,
-  // dispatches to the given Enumerator.
-  bt_cb_ret on_new_event(bt_ctf_event* event)
+  // Assembles a ctf::Event from the given babeltrace event, decoding all of its fields.
+  // Throws std::runtime_error in case of issues.
+  ctf::Event process_event(const bt_ctf_event* event)
   {
     ctf::Event e
     {
@@ -200,25 +754,107 @@ struct CallbackContext
       }
     }
 
-    // Call out to the enumerator with the assembled event.
-    return to_c_api(enumerator(e));
+    return e;
   }
 
-  ctf::Trace::EventEnumerator enumerator;
-};
-}
-
-/// @brief Returns an iterateable vector of scopes.
-const std::vector<ctf::Scope>& ctf::scopes()
-{
-  static const std::vector<ctf::Scope> instance
+  // Assembles a ctf::Event from the given babeltrace event, decoding only the given fields.
+  // Throws std::runtime_error in case of issues.
+  ctf::Event process_event(const bt_ctf_event* event, const std::vector<ctf::Event::Key>& fields)
   {
-    ctf::Scope::trace_packet_header,
-    ctf::Scope::stream_packet_context,
-    ctf::Scope::stream_event_header,
-    ctf::Scope::stream_event_context,
-    ctf::Scope::event_context,
-    ctf::Scope::event_fields
+    ctf::Event e
+    {
+      bt_ctf_event_name(event),
+      bt_ctf_get_cycles(event),
+      std::chrono::nanoseconds{bt_ctf_get_timestamp(event)},
+      ctf::Event::Fields{}
+    };
+
+    for (const auto& key : fields)
+    {
+      auto scope = bt_ctf_get_top_level_scope(event, static_cast<bt_ctf_scope>(std::get<0>(key)));
+
+      if (not scope)
+        continue;
+
+      if (auto def = bt_ctf_get_field(event, scope, std::get<1>(key).c_str()))
+        e.fields.insert(std::make_pair(key, process_field_definition(event, def)));
+    }
+
+    return e;
+  }
+
+  EnumerationLabels labels;
+};
+
+// CallbackContext encapsulates handling of event callbacks issued by babeltrace for individual events in a trace.
+struct CallbackContext
+{
+  // on_new_event is invoked whenever a new event is visited in a trace,
+  // just dispatches to the member function of the same name.
+  static bt_cb_ret on_new_event(bt_ctf_event* event, void* cookie)
+  {
+    auto thiz = static_cast<CallbackContext*>(cookie);
+    return thiz->on_new_event(event);
+  }
+
+  // on_new_event is invoked whenever a new event is visited in a trace,
+  // dispatches to the given Enumerator.
+  bt_cb_ret on_new_event(bt_ctf_event* event)
+  {
+    if (recorder)
+      recorder->on_event(event);
+
+    if (prefetcher)
+      prefetcher->at(bt_ctf_get_cycles(event));
+
+    // Events not selected by the sampler are skipped before touching any of their fields.
+    if (not sampler.accept(event))
+      return BT_CB_OK;
+
+    if (not recorder)
+      return handle(enumerator(decoder.process_event(event)));
+
+    auto before_decode = Recorder::Clock::now();
+    auto e = decoder.process_event(event);
+    auto before_enumerator = Recorder::Clock::now();
+    auto reply = enumerator(e);
+    auto after_enumerator = Recorder::Clock::now();
+
+    recorder->on_decoded(before_enumerator - before_decode, after_enumerator - before_enumerator);
+
+    return handle(reply);
+  }
+
+  // Remembers whether the enumerator asked to stop, translating its reply for babeltrace.
+  bt_cb_ret handle(ctf::Trace::EventEnumeratorReply reply)
+  {
+    stopped = stopped ||
+        reply == ctf::Trace::EventEnumeratorReply::stop ||
+        reply == ctf::Trace::EventEnumeratorReply::stop_with_error;
+
+    return to_c_api(reply);
+  }
+
+  ctf::Trace::EventEnumerator enumerator;
+  Sampler& sampler;
+  Recorder* recorder;
+  bool stopped;
+  Decoder decoder;
+  Prefetcher* prefetcher;
+};
+}
+
+/// @brief Returns an iterateable vector of scopes.
+const std::vector<ctf::Scope>& ctf::scopes()
+{
+  static const std::vector<ctf::Scope> instance
+  {
+    ctf::Scope::trace_packet_header,
+    ctf::Scope::stream_packet_context,
+    ctf::Scope::stream_event_header,
+    ctf::Scope::stream_event_context,
+    ctf::Scope::event_context,
+    ctf::Scope::event_fields
   };
 
   return instance;
@@ -302,6 +938,109 @@ std::uint64_t ctf::Integer::as_uint64() const
   return boost::get<std::uint64_t>(value_);
 }
 
+ctf::StringView::StringView() noexcept
+    : data_(""),
+      size_(0)
+{
+}
+
+ctf::StringView::StringView(const char* data) noexcept
+    : data_(data),
+      size_(std::strlen(data))
+{
+}
+
+ctf::StringView::StringView(const char* data, std::size_t size) noexcept
+    : data_(data),
+      size_(size)
+{
+}
+
+ctf::StringView::StringView(const std::string& s) noexcept
+    : data_(s.data()),
+      size_(s.size())
+{
+}
+
+const char* ctf::StringView::data() const
+{
+  return data_;
+}
+
+std::size_t ctf::StringView::size() const
+{
+  return size_;
+}
+
+bool ctf::StringView::empty() const
+{
+  return size_ == 0;
+}
+
+const char* ctf::StringView::begin() const
+{
+  return data_;
+}
+
+const char* ctf::StringView::end() const
+{
+  return data_ + size_;
+}
+
+std::string ctf::StringView::str() const
+{
+  return std::string(data_, size_);
+}
+
+bool ctf::operator==(const ctf::StringView& lhs, const ctf::StringView& rhs) noexcept(true)
+{
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+bool ctf::operator!=(const ctf::StringView& lhs, const ctf::StringView& rhs) noexcept(true)
+{
+  return not (lhs == rhs);
+}
+
+bool ctf::operator<(const ctf::StringView& lhs, const ctf::StringView& rhs) noexcept(true)
+{
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+std::ostream& ctf::operator<<(std::ostream& out, const ctf::StringView& view)
+{
+  return out.write(view.data(), view.size());
+}
+
+namespace
+{
+// Returns the contiguous elements of type T held by the given array or sequence value, nullptr if there are none.
+// Empty arrays and sequences have no element telling their representation, and are treated as empty buffers of every type.
+template<typename T>
+const std::vector<T>* contiguous_elements(ctf::Field::Type type, const ctf::Field::Variant& value)
+{
+  static const std::vector<T> empty;
+
+  if (auto elements = boost::get<std::vector<T>>(&value))
+    return elements;
+
+  if (type != ctf::Field::Type::array && type != ctf::Field::Type::sequence)
+    return nullptr;
+
+  auto collection = boost::get<std::vector<ctf::Field::Variant>>(&value);
+  return collection && collection->empty() ? &empty : nullptr;
+}
+
+template<typename T>
+const std::vector<T>& contiguous_elements_or_throw(ctf::Field::Type type, const ctf::Field::Variant& value)
+{
+  if (auto elements = contiguous_elements<T>(type, value))
+    return *elements;
+
+  throw boost::bad_get{};
+}
+}
+
 ctf::Field::Field(const std::string& name, ctf::Field::Type type, const ctf::Field::Variant& value)
     : name_(name),
       type_(type),
@@ -316,7 +1055,24 @@ ctf::Field::Type ctf::Field::type() const
 
 bool ctf::Field::is_a(Type type) const
 {
-  return type_ == type;
+  switch (type)
+  {
+    case Type::array:
+    case Type::sequence:
+      return type_ == type && boost::get<std::vector<ctf::Field::Variant>>(&value_);
+    case Type::byte_array:
+      return contiguous_elements<std::uint8_t>(type_, value_);
+    case Type::int64_array:
+      return contiguous_elements<std::int64_t>(type_, value_);
+    case Type::uint64_array:
+      return contiguous_elements<std::uint64_t>(type_, value_);
+    case Type::floating_point_array:
+      return contiguous_elements<double>(type_, value_);
+    case Type::string:
+      return boost::get<ctf::StringView>(&value_);
+    default:
+      return type_ == type;
+  }
 }
 
 const std::string& ctf::Field::name() const
@@ -344,9 +1100,14 @@ const ctf::Enumerator& ctf::Field::as_enumerator() const
   return boost::get<ctf::Enumerator>(value_);
 }
 
-const std::string& ctf::Field::as_string() const
+std::string ctf::Field::as_string() const
 {
-  return boost::get<std::string>(value_);
+  return as_string_view().str();
+}
+
+const ctf::StringView& ctf::Field::as_string_view() const
+{
+  return boost::get<ctf::StringView>(value_);
 }
 
 const ctf::Field::Variant& ctf::Field::unwrap() const
@@ -359,6 +1120,26 @@ const std::vector<ctf::Field::Variant>& ctf::Field::as_collection() const
   return boost::get<std::vector<ctf::Field::Variant>>(value_);
 }
 
+const std::vector<std::uint8_t>& ctf::Field::as_bytes() const
+{
+  return contiguous_elements_or_throw<std::uint8_t>(type_, value_);
+}
+
+const std::vector<std::int64_t>& ctf::Field::as_int64_array() const
+{
+  return contiguous_elements_or_throw<std::int64_t>(type_, value_);
+}
+
+const std::vector<std::uint64_t>& ctf::Field::as_uint64_array() const
+{
+  return contiguous_elements_or_throw<std::uint64_t>(type_, value_);
+}
+
+const std::vector<double>& ctf::Field::as_floating_point_array() const
+{
+  return contiguous_elements_or_throw<double>(type_, value_);
+}
+
 std::ostream& ctf::operator<<(std::ostream& out, const ctf::Integer& integer)
 {
   if (integer.is_empty())
@@ -403,6 +1184,14 @@ std::ostream& ctf::operator<<(std::ostream& out, const ctf::Field::Type& type)
       out << "array"; break;
     case Field::Type::sequence:
       out << "sequence"; break;
+    case Field::Type::byte_array:
+      out << "byte_array"; break;
+    case Field::Type::int64_array:
+      out << "int64_array"; break;
+    case Field::Type::uint64_array:
+      out << "uint64_array"; break;
+    case Field::Type::floating_point_array:
+      out << "floating_point_array"; break;
   }
   return out;
 }
@@ -426,6 +1215,21 @@ struct PrintVisitor : public boost::static_visitor<std::ostream&>
     return out << value;
   }
 
+  template<typename T>
+  std::ostream& operator()(const std::vector<T>& values) const
+  {
+    return ctf::operator<<(out, values);
+  }
+
+  // Bytes are printed as numbers, not as characters.
+  std::ostream& operator()(const std::vector<std::uint8_t>& bytes) const
+  {
+    for (auto byte : bytes)
+      out << static_cast<std::uint32_t>(byte) << " ";
+
+    return out;
+  }
+
   std::ostream& out;
 };
 }
@@ -485,16 +1289,9 @@ typedef void (*packet_seek)(struct bt_stream_pos *pos, size_t index, int whence)
 packet_seek the_empty_seek_function(nullptr);
 bt_mmap_stream_list* the_empty_stream_list(nullptr);
 FILE* the_empty_metadata_file(nullptr);
-}
-
-ctf::Trace::Trace(const boost::filesystem::path& path)
-    : path_(find_directory_with_meta_data(path)),
-      context(bt_context_create()),
-      trace_handle(bt_context_add_trace(context, path_.c_str(), "ctf", the_empty_seek_function, the_empty_stream_list, the_empty_metadata_file))
-{
-}
 
-void ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator)
+// Walks all events of all traces in the given context, invoking the given callback with the given cookie.
+void walk(bt_context* context, bt_cb_ret (*callback)(bt_ctf_event*, void*), void* cookie)
 {
   static bt_dependencies* the_empty_dependencies(nullptr);
   static const bt_iter_pos* begin(nullptr);
@@ -502,15 +1299,17 @@ void ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator)
   static const bt_intern_str call_back_for_all_events(0);
   static const int the_empty_flags(0);
 
-  CallbackContext cb_context{enumerator};
-
   bt_ctf_iter* it = bt_ctf_iter_create(context, begin, end);
+
+  if (not it)
+    throw std::runtime_error("Could not create an iterator for the trace");
+
   bt_ctf_iter_add_callback(
       it,
       call_back_for_all_events,
-      &cb_context,
+      cookie,
       the_empty_flags,
-      CallbackContext::on_new_event,
+      callback,
       the_empty_dependencies,
       the_empty_dependencies,
       the_empty_dependencies);
@@ -521,4 +1320,620 @@ void ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator)
     if (bt_iter_next(bt_ctf_get_iter(it)) < 0)
       break;
   }
+
+  bt_ctf_iter_destroy(it);
+}
+
+// Returns the stream files of the trace in the given directory, in lexicographical order.
+std::vector<boost::filesystem::path> stream_files_in(const boost::filesystem::path& dir)
+{
+  std::vector<boost::filesystem::path> result;
+
+  for (boost::filesystem::directory_iterator it(dir), itE; it != itE; ++it)
+  {
+    auto name = it->path().filename().string();
+
+    if (name == "metadata" || name.empty() || name[0] == '.')
+      continue;
+
+    if (boost::filesystem::is_regular_file(it->path()))
+      result.push_back(it->path());
+  }
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// ScratchDirectory is a uniquely named temporary directory that is removed on destruction.
+class ScratchDirectory
+{
+ public:
+  ScratchDirectory()
+      : dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-ctf-%%%%-%%%%-%%%%"))
+  {
+    boost::filesystem::create_directories(dir);
+  }
+
+  ~ScratchDirectory()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(dir, ec);
+  }
+
+  const boost::filesystem::path dir;
+};
+
+// StreamContext opens an individual stream of a trace in a babeltrace context of its own.
+// babeltrace only opens whole trace directories, so the stream is presented to it in a
+// directory of its own, next to symlinks to the trace's metadata and packet index.
+class StreamContext
+{
+ public:
+  StreamContext(const boost::filesystem::path& trace, const boost::filesystem::path& stream, const boost::filesystem::path& dir)
+      : dir(dir),
+        context(nullptr)
+  {
+    auto absolute_trace = boost::filesystem::absolute(trace);
+    auto name = stream.filename();
+    auto index = absolute_trace / "index" / (name.string() + ".idx");
+
+    boost::filesystem::create_directories(dir);
+    boost::filesystem::create_symlink(absolute_trace / "metadata", dir / "metadata");
+    boost::filesystem::create_symlink(absolute_trace / name, dir / name);
+
+    if (boost::filesystem::exists(index))
+    {
+      boost::filesystem::create_directory(dir / "index");
+      boost::filesystem::create_symlink(index, dir / "index" / index.filename());
+    }
+
+    context = bt_context_create();
+
+    if (bt_context_add_trace(context, dir.c_str(), "ctf", the_empty_seek_function, the_empty_stream_list, the_empty_metadata_file) < 0)
+    {
+      bt_context_put(context);
+      throw std::runtime_error("Could not open stream " + stream.string());
+    }
+  }
+
+  StreamContext(const StreamContext&) = delete;
+  StreamContext& operator=(const StreamContext&) = delete;
+
+  ~StreamContext()
+  {
+    bt_context_put(context);
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(dir, ec);
+  }
+
+  const boost::filesystem::path dir;
+  bt_context* context;
+};
+
+// Invokes f for the babeltrace contexts covering the trace in the given directory, in the given order,
+// passing the stream files read through the respective context. Stops as soon as f returns false.
+template<typename Function>
+void for_each_context(const boost::filesystem::path& dir, bt_context* context, ctf::Ordering ordering, Function f)
+{
+  switch (ordering)
+  {
+    case ctf::Ordering::timestamp:
+      f(context, stream_files_in(dir));
+      break;
+    case ctf::Ordering::none:
+      {
+        ScratchDirectory scratch;
+        std::size_t i{0};
+
+        for (const auto& stream : stream_files_in(dir))
+        {
+          StreamContext stream_context{dir, stream, scratch.dir / std::to_string(i++)};
+
+          if (not f(stream_context.context, std::vector<boost::filesystem::path>{stream}))
+            break;
+        }
+      }
+      break;
+  }
+}
+}
+
+namespace
+{
+// Returns the directory that symlinks to anonymous memory files are placed in, preferring a tmpfs.
+boost::filesystem::path directory_for_memory_files()
+{
+  static const boost::filesystem::path shm{"/dev/shm"};
+
+  if (boost::filesystem::is_directory(shm))
+    return shm;
+
+  return boost::filesystem::temp_directory_path();
+}
+
+// Makes the file referred to by the given descriptor available in dir under the given name.
+// babeltrace only opens traces from directories, so the file is presented to it by
+// a symlink to its entry in /proc/self/fd.
+void present_file(const boost::filesystem::path& dir, const std::string& name, int fd)
+{
+  if (fd < 0 || ::fcntl(fd, F_GETFD) < 0)
+    throw std::invalid_argument("Invalid file descriptor for " + name);
+
+  boost::filesystem::create_symlink("/proc/self/fd/" + std::to_string(fd), dir / name);
+}
+
+// Throws if the given name cannot be presented as a stream file.
+void check_stream_name(const std::string& name)
+{
+  if (name.empty() || name[0] == '.' || name == "metadata" || name.find('/') != std::string::npos)
+    throw std::invalid_argument("Invalid name for stream: " + name);
+}
+
+// Copies the given buffer to an anonymous memory file and makes it available
+// in dir under the given name, returning the file descriptor of the memory file.
+int add_memory_file(const boost::filesystem::path& dir, const std::string& name, const ctf::Trace::Buffer& buffer)
+{
+  int fd = ::memfd_create(name.c_str(), MFD_CLOEXEC);
+
+  if (fd < 0)
+    throw std::system_error(errno, std::system_category(), "Could not create memory file for " + name);
+
+  auto data = static_cast<const char*>(buffer.data);
+  auto remaining = buffer.size;
+
+  while (remaining > 0)
+  {
+    auto written = ::write(fd, data, remaining);
+
+    if (written < 0 && errno == EINTR)
+      continue;
+
+    if (written < 0)
+    {
+      auto error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::system_category(), "Could not write memory file for " + name);
+    }
+
+    data += written;
+    remaining -= written;
+  }
+
+  try
+  {
+    present_file(dir, name, fd);
+  }
+  catch (...)
+  {
+    ::close(fd);
+    throw;
+  }
+
+  return fd;
+}
+
+// Closes the given memory files and removes the directory presenting them.
+void release_memory_files(const boost::filesystem::path& dir, const std::vector<int>& fds)
+{
+  for (auto fd : fds)
+    ::close(fd);
+
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(dir, ec);
+}
+}
+
+ctf::Trace::Trace(const boost::filesystem::path& path)
+    : path_(find_directory_with_meta_data(path)),
+      context(bt_context_create()),
+      trace_handle(bt_context_add_trace(context, path_.c_str(), "ctf", the_empty_seek_function, the_empty_stream_list, the_empty_metadata_file)),
+      statistics_(),
+      in_memory_(false)
+{
+  if (trace_handle < 0)
+  {
+    bt_context_put(context);
+    throw std::runtime_error("Could not open trace in " + path_.string());
+  }
+}
+
+ctf::Trace::Trace(const ctf::Trace::Buffer& metadata, const ctf::Trace::StreamBuffers& streams)
+    : path_(directory_for_memory_files() / boost::filesystem::unique_path("lttng-ctf-%%%%-%%%%-%%%%")),
+      context(bt_context_create()),
+      trace_handle(-1),
+      statistics_(),
+      in_memory_(true)
+{
+  try
+  {
+    boost::filesystem::create_directories(path_);
+
+    memory_files_.push_back(add_memory_file(path_, "metadata", metadata));
+
+    for (const auto& pair : streams)
+    {
+      check_stream_name(pair.first);
+      memory_files_.push_back(add_memory_file(path_, pair.first, pair.second));
+    }
+
+    trace_handle = bt_context_add_trace(context, path_.c_str(), "ctf", the_empty_seek_function, the_empty_stream_list, the_empty_metadata_file);
+
+    if (trace_handle < 0)
+      throw std::runtime_error("Could not open trace from memory");
+  }
+  catch (...)
+  {
+    release_memory_files(path_, memory_files_);
+    bt_context_put(context);
+    throw;
+  }
+}
+
+ctf::Trace::Trace(int metadata, const ctf::Trace::StreamFiles& streams)
+    : path_(directory_for_memory_files() / boost::filesystem::unique_path("lttng-ctf-%%%%-%%%%-%%%%")),
+      context(bt_context_create()),
+      trace_handle(-1),
+      statistics_(),
+      in_memory_(true)
+{
+  try
+  {
+    boost::filesystem::create_directories(path_);
+
+    present_file(path_, "metadata", metadata);
+
+    for (const auto& pair : streams)
+    {
+      check_stream_name(pair.first);
+      present_file(path_, pair.first, pair.second);
+    }
+
+    trace_handle = bt_context_add_trace(context, path_.c_str(), "ctf", the_empty_seek_function, the_empty_stream_list, the_empty_metadata_file);
+
+    if (trace_handle < 0)
+      throw std::runtime_error("Could not open trace from memory");
+  }
+  catch (...)
+  {
+    release_memory_files(path_, memory_files_);
+    bt_context_put(context);
+    throw;
+  }
+}
+
+ctf::Trace::~Trace()
+{
+  bt_context_put(context);
+
+  if (in_memory_)
+    release_memory_files(path_, memory_files_);
+}
+
+struct ctf::Trace::Cursor::Private
+{
+  bt_ctf_iter* it;
+  bool started;
+  Decoder decoder;
+};
+
+ctf::Trace::Cursor::Cursor(ctf::Trace& trace)
+    : d(new Private{bt_ctf_iter_create(trace.context, nullptr, nullptr), false, Decoder{}})
+{
+  if (not d->it)
+    throw std::runtime_error("Could not create an iterator for trace in " + trace.path_.string());
+}
+
+ctf::Trace::Cursor::~Cursor()
+{
+  bt_ctf_iter_destroy(d->it);
+}
+
+bool ctf::Trace::Cursor::next(ctf::Event& event)
+{
+  if (d->started && bt_iter_next(bt_ctf_get_iter(d->it)) < 0)
+    return false;
+
+  d->started = true;
+
+  auto ctf_event = bt_ctf_iter_read_event(d->it);
+
+  if (not ctf_event)
+    return false;
+
+  event = d->decoder.process_event(ctf_event);
+  return true;
+}
+
+ctf::Sampling ctf::Sampling::none()
+{
+  return ctf::Sampling{ctf::Sampling::Mode::none, 1, 1., 0};
+}
+
+ctf::Sampling ctf::Sampling::every_nth_per_event_class(std::uint64_t n)
+{
+  if (n == 0)
+    throw std::invalid_argument("Sampling::every_nth_per_event_class: n must not be 0");
+
+  return ctf::Sampling{ctf::Sampling::Mode::every_nth_per_event_class, n, 1., 0};
+}
+
+ctf::Sampling ctf::Sampling::bernoulli(double probability, std::uint64_t seed)
+{
+  if (probability < 0. || probability > 1.)
+    throw std::invalid_argument("Sampling::bernoulli: probability must be in [0, 1]");
+
+  return ctf::Sampling{ctf::Sampling::Mode::bernoulli, 1, probability, seed};
+}
+
+ctf::Sampling ctf::Sampling::packets(std::uint64_t n)
+{
+  if (n == 0)
+    throw std::invalid_argument("Sampling::packets: n must not be 0");
+
+  return ctf::Sampling{ctf::Sampling::Mode::packets, n, 1., 0};
+}
+
+std::chrono::nanoseconds ctf::Statistics::reader_time() const
+{
+  return elapsed - decode_time - enumerator_time;
+}
+
+double ctf::SamplingReport::Counters::rate() const
+{
+  if (seen == 0)
+    return 1.;
+
+  return static_cast<double>(delivered) / seen;
+}
+
+double ctf::SamplingReport::Counters::scale() const
+{
+  // Nothing delivered leaves nothing to scale up, and must not turn aggregates into inf or NaN.
+  if (delivered == 0)
+    return 0.;
+
+  return 1. / rate();
+}
+
+void ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator)
+{
+  for_each_event(enumerator, ctf::Sampling::none());
+}
+
+void ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator, ctf::Ordering ordering)
+{
+  for_each_event(enumerator, ctf::Sampling::none(), ordering);
+}
+
+ctf::SamplingReport ctf::Trace::for_each_event(ctf::Trace::EventEnumerator enumerator, const ctf::Sampling& sampling, ctf::Ordering ordering)
+{
+  Sampler sampler{sampling};
+  std::unique_ptr<Recorder> recorder;
+
+  if (instrumentation_)
+    recorder.reset(new Recorder{*instrumentation_, statistics_});
+
+  CallbackContext cb_context{enumerator, sampler, recorder.get(), false, Decoder{}, nullptr};
+
+  for_each_context(path_, context, ordering, [this, &cb_context, &sampler](bt_context* c, const std::vector<boost::filesystem::path>& streams)
+  {
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    if (prefetching_)
+      prefetcher.reset(new Prefetcher{streams, *prefetching_});
+
+    cb_context.prefetcher = prefetcher.get();
+    cb_context.decoder.labels.clear();
+
+    walk(c, CallbackContext::on_new_event, &cb_context);
+
+    // Declarations and definitions are owned by the context, forget them before it is released.
+    sampler.leave_context();
+    if (cb_context.recorder)
+      cb_context.recorder->leave_context();
+
+    cb_context.prefetcher = nullptr;
+    return not cb_context.stopped;
+  });
+
+  if (recorder)
+    recorder->finish();
+
+  return sampler.finish();
+}
+
+namespace
+{
+// DispatchContext routes the events of a trace to the analyses of a dispatcher.
+struct DispatchContext
+{
+  // Route describes the analyses interested in an event class, and the fields they need.
+  struct Route
+  {
+    std::vector<const ctf::Dispatcher::Handler*> handlers;
+    std::vector<ctf::Event::Key> fields;
+    bool all_fields;
+  };
+
+  // on_new_event is invoked whenever a new event is visited in a trace,
+  // just dispatches to the member function of the same name.
+  static bt_cb_ret on_new_event(bt_ctf_event* event, void* cookie)
+  {
+    auto thiz = static_cast<DispatchContext*>(cookie);
+    return thiz->on_new_event(event);
+  }
+
+  // on_new_event is invoked whenever a new event is visited in a trace,
+  // decoding the event for and dispatching to the interested analyses.
+  bt_cb_ret on_new_event(bt_ctf_event* event)
+  {
+    if (prefetcher)
+      prefetcher->at(bt_ctf_get_cycles(event));
+
+    auto decl = bt_ctf_event_get_decl(event);
+    auto it = routes.find(decl);
+
+    if (it == routes.end())
+      it = routes.insert(std::make_pair(decl, route_for(decl))).first;
+
+    const auto& route = it->second;
+
+    if (route.handlers.empty())
+      return BT_CB_OK;
+
+    auto e = route.all_fields ? decoder.process_event(event) : decoder.process_event(event, route.fields);
+
+    for (auto handler : route.handlers)
+      (*handler)(e);
+
+    return BT_CB_OK;
+  }
+
+  // Assembles the route for the event class with the given declaration.
+  Route route_for(const bt_ctf_event_decl* decl) const
+  {
+    static constexpr const std::size_t idx_interest{0};
+    static constexpr const std::size_t idx_handler{1};
+
+    Route route{{}, {}, false};
+    std::string name{bt_ctf_get_decl_event_name(decl)};
+
+    for (const auto& analysis : analyses)
+    {
+      const auto& interest = std::get<idx_interest>(analysis);
+
+      if (not interest.events.empty() && interest.events.count(name) == 0)
+        continue;
+
+      route.handlers.push_back(&std::get<idx_handler>(analysis));
+      route.all_fields = route.all_fields || interest.all_fields;
+
+      for (const auto& key : interest.fields)
+        if (std::find(route.fields.begin(), route.fields.end(), key) == route.fields.end())
+          route.fields.push_back(key);
+    }
+
+    return route;
+  }
+
+  const std::vector<std::tuple<ctf::Dispatcher::Interest, ctf::Dispatcher::Handler>>& analyses;
+  std::unordered_map<const bt_ctf_event_decl*, Route> routes;
+  Decoder decoder;
+  Prefetcher* prefetcher;
+};
+}
+
+void ctf::Dispatcher::add(const ctf::Dispatcher::Interest& interest, const ctf::Dispatcher::Handler& handler)
+{
+  analyses.push_back(std::make_tuple(interest, handler));
+}
+
+void ctf::Dispatcher::run(ctf::Trace& trace, ctf::Ordering ordering)
+{
+  DispatchContext dispatch_context{analyses, {}, Decoder{}, nullptr};
+
+  for_each_context(trace.path_, trace.context, ordering, [&trace, &dispatch_context](bt_context* c, const std::vector<boost::filesystem::path>& streams)
+  {
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    if (trace.prefetching_)
+      prefetcher.reset(new Prefetcher{streams, *trace.prefetching_});
+
+    // Declarations are owned by the context, routes and labels are only valid for it.
+    dispatch_context.routes.clear();
+    dispatch_context.decoder.labels.clear();
+    dispatch_context.prefetcher = prefetcher.get();
+
+    walk(c, DispatchContext::on_new_event, &dispatch_context);
+
+    dispatch_context.prefetcher = nullptr;
+    return true;
+  });
+}
+
+namespace
+{
+// RawCallbackContext hands babeltrace events to a RawEventEnumerator.
+struct RawCallbackContext
+{
+  // on_new_event is invoked whenever a new event is visited in a trace,
+  // dispatches to the given enumerator.
+  static bt_cb_ret on_new_event(bt_ctf_event* event, void* cookie)
+  {
+    auto thiz = static_cast<RawCallbackContext*>(cookie);
+
+    if (thiz->prefetcher)
+      thiz->prefetcher->at(bt_ctf_get_cycles(event));
+
+    auto reply = thiz->enumerator(event);
+
+    thiz->stopped = thiz->stopped ||
+        reply == ctf::Trace::EventEnumeratorReply::stop ||
+        reply == ctf::Trace::EventEnumeratorReply::stop_with_error;
+
+    return to_c_api(reply);
+  }
+
+  ctf::Trace::RawEventEnumerator enumerator;
+  bool stopped;
+  Prefetcher* prefetcher;
+};
+}
+
+void ctf::Trace::for_each_raw_event(ctf::Trace::RawEventEnumerator enumerator, ctf::Ordering ordering)
+{
+  for_each_raw_event(enumerator, ordering, ctf::Trace::ContextHandler{});
+}
+
+void ctf::Trace::for_each_raw_event(ctf::Trace::RawEventEnumerator enumerator, ctf::Ordering ordering, ctf::Trace::ContextHandler on_context)
+{
+  RawCallbackContext cb_context{enumerator, false, nullptr};
+
+  for_each_context(path_, context, ordering, [this, &cb_context, &on_context](bt_context* c, const std::vector<boost::filesystem::path>& streams)
+  {
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    if (prefetching_)
+      prefetcher.reset(new Prefetcher{streams, *prefetching_});
+
+    if (on_context)
+      on_context();
+
+    cb_context.prefetcher = prefetcher.get();
+    walk(c, RawCallbackContext::on_new_event, &cb_context);
+    cb_context.prefetcher = nullptr;
+
+    return not cb_context.stopped;
+  });
+}
+
+void ctf::Trace::enable_instrumentation(const ctf::Instrumentation& instrumentation)
+{
+  instrumentation_ = instrumentation;
+}
+
+void ctf::Trace::disable_instrumentation()
+{
+  instrumentation_ = boost::none;
+}
+
+ctf::Prefetching ctf::Prefetching::defaults()
+{
+  return ctf::Prefetching{8, true, std::chrono::milliseconds{5}};
+}
+
+void ctf::Trace::enable_prefetching(const ctf::Prefetching& prefetching)
+{
+  prefetching_ = prefetching;
+}
+
+void ctf::Trace::disable_prefetching()
+{
+  prefetching_ = boost::none;
+}
+
+ctf::Statistics ctf::Trace::statistics() const
+{
+  return statistics_;
 }
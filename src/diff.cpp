@@ -0,0 +1,263 @@
+#include <lttng/diff.h>
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+// Side identifies one of the traces that are compared.
+enum Side
+{
+  baseline = 0,
+  candidate = 1
+};
+
+// Renders the values of the given key fields of the given event.
+// Missing fields render empty, such that events lacking them still form a group.
+std::string key_of(const ctf::Event& event, const std::vector<ctf::Event::Key>& key_fields)
+{
+  if (key_fields.empty())
+    return std::string{};
+
+  std::ostringstream ss;
+
+  for (const auto& key : key_fields)
+  {
+    auto it = event.fields.find(key);
+    if (it != event.fields.end())
+      ss << it->second.value();
+    ss << ";";
+  }
+
+  return ss.str();
+}
+
+// Pending is an event of one trace that has not been matched with an event of the other trace yet.
+struct Pending
+{
+  std::string name;
+  std::chrono::nanoseconds offset;
+};
+
+// Group tracks the events sharing the values of all key fields.
+struct Group
+{
+  std::deque<Pending> pending; // Unmatched events of the side that is ahead.
+  Side ahead{baseline}; // The side pending events belong to.
+  std::uint64_t matched{0}; // Number of events matched so far.
+  boost::optional<std::chrono::nanoseconds> last[2]; // Offset of the previous event, per side.
+};
+
+// Comparison consumes the events of both traces, in lockstep.
+class Comparison
+{
+ public:
+  explicit Comparison(const ctf::diff::Options& options)
+      : options(options),
+        pending(0)
+  {
+  }
+
+  void consume(Side side, const ctf::Event& event, std::chrono::nanoseconds offset)
+  {
+    auto& klass = report.per_event_class[event.name];
+
+    if (side == baseline)
+    {
+      report.baseline_events++;
+      klass.baseline++;
+    }
+    else
+    {
+      report.candidate_events++;
+      klass.candidate++;
+    }
+
+    auto key = key_of(event, options.key_fields);
+    auto it = groups.find(key);
+
+    // After the first divergence, latencies are only tracked for known groups, such that
+    // memory stays bounded for keys of high cardinality.
+    if (it == groups.end())
+    {
+      if (report.first_divergence)
+        return;
+
+      it = groups.emplace(key, Group{}).first;
+    }
+
+    auto& group = it->second;
+
+    if (group.last[side])
+      (side == baseline ? klass.baseline_latency : klass.candidate_latency).add(offset - *group.last[side]);
+    group.last[side] = offset;
+
+    // Alignment stops at the first divergence.
+    if (report.first_divergence)
+      return;
+
+    if (group.pending.empty() || group.ahead == side)
+    {
+      group.ahead = side;
+      group.pending.push_back(Pending{event.name, offset});
+
+      // The window is shared by all groups, the oldest pending event of all of them diverges.
+      if (++pending > options.window)
+      {
+        auto oldest = oldest_pending();
+        diverge(oldest->first, oldest->second, nullptr, oldest->second.pending.front().offset);
+      }
+
+      return;
+    }
+
+    if (group.pending.front().name != event.name)
+    {
+      diverge(key, group, &event, offset);
+      return;
+    }
+
+    group.pending.pop_front();
+    group.matched++;
+    pending--;
+  }
+
+  ctf::diff::Report finish()
+  {
+    if (report.first_divergence)
+      return report;
+
+    // Events left unmatched at the end of both traces diverge, the earliest of them first.
+    auto oldest = oldest_pending();
+
+    if (oldest != groups.end())
+      diverge(oldest->first, oldest->second, nullptr, oldest->second.pending.front().offset);
+
+    return report;
+  }
+
+ private:
+  typedef std::unordered_map<std::string, Group> Groups;
+
+  // Returns the group holding the earliest pending event, end() if no event is pending.
+  Groups::iterator oldest_pending()
+  {
+    auto result = groups.end();
+
+    for (auto it = groups.begin(); it != groups.end(); ++it)
+      if (not it->second.pending.empty() && (result == groups.end() || it->second.pending.front().offset < result->second.pending.front().offset))
+        result = it;
+
+    return result;
+  }
+
+  // Records a divergence of the oldest pending event of the given group and
+  // the given event of the other side, which is null if there is none.
+  void diverge(const std::string& key, Group& group, const ctf::Event* event, std::chrono::nanoseconds offset)
+  {
+    const auto& front = group.pending.front();
+    auto other = event ? event->name : std::string{};
+
+    report.first_divergence = ctf::diff::Divergence
+    {
+      key,
+      group.matched,
+      group.ahead == baseline ? front.name : other,
+      group.ahead == baseline ? other : front.name,
+      std::min(front.offset, offset)
+    };
+
+    // Pending events are of no further use.
+    for (auto& pair : groups)
+      pair.second.pending.clear();
+    pending = 0;
+  }
+
+  const ctf::diff::Options& options;
+  Groups groups;
+  std::size_t pending; // Pending events across all groups.
+  ctf::diff::Report report;
+};
+
+// Source pulls the events of a trace, alongside their offset to the first event of the trace.
+class Source
+{
+ public:
+  explicit Source(ctf::Trace& trace)
+      : cursor(trace),
+        available(cursor.next(event)),
+        start(available ? event.timestamp : std::chrono::nanoseconds{0})
+  {
+  }
+
+  std::chrono::nanoseconds offset() const
+  {
+    return event.timestamp - start;
+  }
+
+  void advance()
+  {
+    available = cursor.next(event);
+  }
+
+  ctf::Trace::Cursor cursor;
+  ctf::Event event;
+  bool available;
+  std::chrono::nanoseconds start;
+};
+}
+
+std::int64_t ctf::diff::EventClassReport::delta() const
+{
+  return static_cast<std::int64_t>(candidate) - static_cast<std::int64_t>(baseline);
+}
+
+std::chrono::nanoseconds ctf::diff::EventClassReport::shift(double q) const
+{
+  return candidate_latency.quantile(q) - baseline_latency.quantile(q);
+}
+
+ctf::diff::Report ctf::diff::compare(ctf::Trace& baseline_trace, ctf::Trace& candidate_trace, const ctf::diff::Options& options)
+{
+  Source b{baseline_trace}, c{candidate_trace};
+  Source* sources[2]{&b, &c};
+  Comparison comparison{options};
+
+  while (b.available || c.available)
+  {
+    // Consume from the trace that is behind, relative to its start.
+    Side side = not c.available || (b.available && b.offset() <= c.offset()) ? baseline : candidate;
+
+    comparison.consume(side, sources[side]->event, sources[side]->offset());
+    sources[side]->advance();
+  }
+
+  return comparison.finish();
+}
+
+std::ostream& ctf::diff::operator<<(std::ostream& out, const ctf::diff::Report& report)
+{
+  out << "baseline: " << report.baseline_events << " events" << "\n"
+      << "candidate: " << report.candidate_events << " events" << "\n";
+
+  for (const auto& pair : report.per_event_class)
+  {
+    const auto& r = pair.second;
+    out << "  " << pair.first << ": "
+        << r.baseline << " -> " << r.candidate << " (" << std::showpos << r.delta() << std::noshowpos << ")"
+        << " p50 shift: " << r.shift(.5).count() << " [ns]"
+        << " p99 shift: " << r.shift(.99).count() << " [ns]" << "\n";
+  }
+
+  if (not report.first_divergence)
+    return out << "traces align" << "\n";
+
+  const auto& d = *report.first_divergence;
+  return out << "first divergence after " << d.offset.count() << " [ns] at event " << d.index
+             << " of group '" << d.key << "': "
+             << (d.baseline.empty() ? "(none)" : d.baseline) << " vs. "
+             << (d.candidate.empty() ? "(none)" : d.candidate) << "\n";
+}
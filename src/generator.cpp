@@ -0,0 +1,549 @@
+#include <lttng/generator.h>
+#include <lttng/lttng.h>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// The uuid of every generated trace, in textual and binary representation.
+constexpr const char* the_uuid{"6b6c7474-6e67-2d67-656e-657261746f72"};
+constexpr const unsigned char the_uuid_bytes[16]
+{
+  0x6b, 0x6c, 0x74, 0x74, 0x6e, 0x67, 0x2d, 0x67, 0x65, 0x6e, 0x65, 0x72, 0x61, 0x74, 0x6f, 0x72
+};
+
+constexpr const std::uint32_t the_packet_magic{0xC1FC1FC1};
+// The start of the trace, in seconds since the epoch.
+constexpr const std::uint64_t the_clock_offset_s{1500000000};
+// Fixed width of the procname context, as used by lttng-ust.
+constexpr const std::size_t the_procname_length{17};
+// Every n-th event of Mix::mixed is a soinfo event.
+constexpr const std::uint64_t the_soinfo_period{1000};
+// The name of the event class of Mix::types, which lttng-ust has no counterpart for.
+constexpr const char* the_types_event{"ust_generator:types"};
+
+// Event ids as declared in the metadata below.
+enum EventId : std::uint32_t
+{
+  malloc_id = 0,
+  free_id,
+  calloc_id,
+  realloc_id,
+  memalign_id,
+  posix_memalign_id,
+  mutex_lock_req_id,
+  mutex_lock_acq_id,
+  mutex_trylock_id,
+  mutex_unlock_id,
+  soinfo_id,
+  types_id
+};
+
+// Event classes, in id order, with their payload in TSDL.
+struct EventClass
+{
+  const char* name;
+  const char* fields;
+};
+
+const std::vector<EventClass>& event_classes()
+{
+  namespace libc = lttng::events::userspace::libc;
+  namespace pthread = lttng::events::userspace::pthread;
+
+  static const std::vector<EventClass> instance
+  {
+    {libc::malloc, "uint64_t _size; uint64_hex_t _ptr;"},
+    {libc::free, "uint64_hex_t _ptr;"},
+    {libc::calloc, "uint64_t _nmemb; uint64_t _size; uint64_hex_t _ptr;"},
+    {libc::realloc, "uint64_hex_t _in_ptr; uint64_t _size; uint64_hex_t _ptr;"},
+    {libc::memalign, "uint64_t _alignment; uint64_t _size; uint64_hex_t _ptr;"},
+    {libc::mem_align, "uint64_hex_t _out_ptr; uint64_t _alignment; uint64_t _size; int32_t _result;"},
+    {pthread::mutex_lock_req, "uint64_hex_t _mutex;"},
+    {pthread::mutex_lock_acq, "uint64_hex_t _mutex; int32_t _status;"},
+    {pthread::mutex_trylock, "uint64_hex_t _mutex; int32_t _status;"},
+    {pthread::mutex_unlock, "uint64_hex_t _mutex; int32_t _status;"},
+    {libc::soinfo, "uint64_hex_t _baddr; uint64_t _memsz; string _sopath; int64_t _size; int64_t _mtime;"},
+    {the_types_event, "enum : uint8_t { ok = 0, busy = 16 } _status; uint32_t _depth; uint64_hex_t _callstack[_depth]; uint8_t _digest[4]; double _ratio;"}
+  };
+
+  return instance;
+}
+
+// Cyclic patterns of events per mix, resembling what a well-behaved program would record.
+const std::vector<EventId>& pattern_of(ctf::generator::Mix mix)
+{
+  static const std::vector<EventId> libc
+  {
+    malloc_id, free_id, calloc_id, free_id, malloc_id, realloc_id, free_id, memalign_id, free_id, posix_memalign_id, free_id
+  };
+
+  static const std::vector<EventId> pthread
+  {
+    mutex_lock_req_id, mutex_lock_acq_id, mutex_unlock_id, mutex_trylock_id, mutex_unlock_id
+  };
+
+  static const std::vector<EventId> mixed
+  {
+    malloc_id, mutex_lock_req_id, mutex_lock_acq_id, realloc_id, mutex_unlock_id, free_id, calloc_id, mutex_trylock_id, mutex_unlock_id, free_id
+  };
+
+  static const std::vector<EventId> strings
+  {
+    soinfo_id
+  };
+
+  static const std::vector<EventId> types
+  {
+    types_id
+  };
+
+  switch (mix)
+  {
+    case ctf::generator::Mix::libc: return libc;
+    case ctf::generator::Mix::pthread: return pthread;
+    case ctf::generator::Mix::mixed: return mixed;
+    case ctf::generator::Mix::strings: return strings;
+    case ctf::generator::Mix::types: return types;
+  }
+
+  throw std::logic_error("pattern_of: we should never reach here.");
+}
+
+std::string metadata()
+{
+  std::string result
+  {
+    "/* CTF 1.8 */\n"
+    "\n"
+    "typealias integer { size = 8; align = 8; signed = false; } := uint8_t;\n"
+    "typealias integer { size = 32; align = 8; signed = false; } := uint32_t;\n"
+    "typealias integer { size = 64; align = 8; signed = false; } := uint64_t;\n"
+    "typealias integer { size = 64; align = 8; signed = false; base = 16; } := uint64_hex_t;\n"
+    "typealias integer { size = 32; align = 8; signed = true; } := int32_t;\n"
+    "typealias integer { size = 64; align = 8; signed = true; } := int64_t;\n"
+    "typealias floating_point { exp_dig = 11; mant_dig = 53; align = 8; } := double;\n"
+    "\n"
+    "trace {\n"
+    "  major = 1;\n"
+    "  minor = 8;\n"
+    "  uuid = \"" + std::string{the_uuid} + "\";\n"
+    "  byte_order = le;\n"
+    "  packet.header := struct {\n"
+    "    uint32_t magic;\n"
+    "    uint8_t uuid[16];\n"
+    "    uint32_t stream_id;\n"
+    "  };\n"
+    "};\n"
+    "\n"
+    "env {\n"
+    "  hostname = \"lttng-generator\";\n"
+    "  domain = \"ust\";\n"
+    "  tracer_name = \"lttng-ust\";\n"
+    "  tracer_major = 2;\n"
+    "  tracer_minor = 7;\n"
+    "};\n"
+    "\n"
+    "clock {\n"
+    "  name = \"monotonic\";\n"
+    "  uuid = \"" + std::string{the_uuid} + "\";\n"
+    "  description = \"Monotonic Clock\";\n"
+    "  freq = 1000000000;\n"
+    "  offset_s = " + std::to_string(the_clock_offset_s) + ";\n"
+    "  offset = 0;\n"
+    "};\n"
+    "\n"
+    "typealias integer { size = 64; align = 8; signed = false; map = clock.monotonic.value; } := uint64_clock_monotonic_t;\n"
+    "\n"
+    "stream {\n"
+    "  id = 0;\n"
+    "  packet.context := struct {\n"
+    "    uint64_clock_monotonic_t timestamp_begin;\n"
+    "    uint64_clock_monotonic_t timestamp_end;\n"
+    "    uint64_t content_size;\n"
+    "    uint64_t packet_size;\n"
+    "    uint64_t events_discarded;\n"
+    "    uint32_t cpu_id;\n"
+    "  };\n"
+    "  event.header := struct {\n"
+    "    uint32_t id;\n"
+    "    uint64_clock_monotonic_t timestamp;\n"
+    "  };\n"
+    "  event.context := struct {\n"
+    "    int32_t _vpid;\n"
+    "    int32_t _vtid;\n"
+    "    integer { size = 8; align = 8; signed = true; encoding = UTF8; base = 10; } _procname[17];\n"
+    "    uint64_hex_t _ip;\n"
+    "  };\n"
+    "};\n"
+  };
+
+  for (std::size_t id = 0; id < event_classes().size(); id++)
+  {
+    result += "\n"
+        "event {\n"
+        "  name = \"" + std::string{event_classes()[id].name} + "\";\n"
+        "  id = " + std::to_string(id) + ";\n"
+        "  stream_id = 0;\n"
+        "  fields := struct { " + std::string{event_classes()[id].fields} + " };\n"
+        "};\n";
+  }
+
+  return result;
+}
+
+// Appends the given integer in little-endian byte order to the given buffer.
+template<typename T>
+void put(std::string& buffer, T value)
+{
+  for (std::size_t i = 0; i < sizeof(T); i++)
+    buffer.push_back(static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xff));
+}
+
+// Overwrites the integer at the given offset in the given buffer, in little-endian byte order.
+template<typename T>
+void patch(std::string& buffer, std::size_t offset, T value)
+{
+  for (std::size_t i = 0; i < sizeof(T); i++)
+    buffer[offset + i] = static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xff);
+}
+
+// StreamWriter packs events into fixed-size packets and writes them to a stream file.
+class StreamWriter
+{
+ public:
+  StreamWriter(const boost::filesystem::path& path, std::uint32_t cpu_id, std::uint32_t packet_size)
+      : out(path, std::ios::binary | std::ios::trunc),
+        cpu_id(cpu_id),
+        packet_size(packet_size),
+        timestamp_begin(0),
+        timestamp_end(0),
+        bytes_written(0)
+  {
+    if (not out)
+      throw std::runtime_error("StreamWriter: could not open " + path.string());
+
+    open_packet();
+  }
+
+  // Appends an event with the given header, context and payload, starting
+  // a new packet if the current one is full.
+  void append(EventId id, std::uint64_t timestamp, const std::string& context, const std::string& payload)
+  {
+    auto size = sizeof(std::uint32_t) + sizeof(std::uint64_t) + context.size() + payload.size();
+
+    if (packet.size() + size > packet_size)
+    {
+      if (packet.size() == header_size)
+        throw std::runtime_error("StreamWriter: event does not fit into a packet");
+
+      close_packet();
+      open_packet();
+    }
+
+    if (packet.size() == header_size)
+      timestamp_begin = timestamp;
+    timestamp_end = timestamp;
+
+    put<std::uint32_t>(packet, id);
+    put<std::uint64_t>(packet, timestamp);
+    packet.append(context);
+    packet.append(payload);
+  }
+
+  // Returns the number of bytes written so far, including the content of the current packet but not its padding.
+  std::uint64_t size() const
+  {
+    return bytes_written + packet.size();
+  }
+
+  // Flushes the last packet and returns the number of bytes written to the stream file.
+  std::uint64_t finish()
+  {
+    if (packet.size() > header_size)
+      close_packet();
+
+    out.flush();
+    return bytes_written;
+  }
+
+ private:
+  // Offsets into the packet header and context.
+  static constexpr const std::size_t timestamp_begin_offset{24};
+  static constexpr const std::size_t timestamp_end_offset{32};
+  static constexpr const std::size_t content_size_offset{40};
+  static constexpr const std::size_t packet_size_offset{48};
+  static constexpr const std::size_t header_size{68};
+
+  void open_packet()
+  {
+    packet.clear();
+    packet.reserve(packet_size);
+
+    put<std::uint32_t>(packet, the_packet_magic);
+    packet.append(reinterpret_cast<const char*>(the_uuid_bytes), sizeof(the_uuid_bytes));
+    put<std::uint32_t>(packet, 0); // stream_id
+
+    put<std::uint64_t>(packet, 0); // timestamp_begin
+    put<std::uint64_t>(packet, 0); // timestamp_end
+    put<std::uint64_t>(packet, 0); // content_size
+    put<std::uint64_t>(packet, 0); // packet_size
+    put<std::uint64_t>(packet, 0); // events_discarded
+    put<std::uint32_t>(packet, cpu_id);
+  }
+
+  void close_packet()
+  {
+    patch<std::uint64_t>(packet, timestamp_begin_offset, timestamp_begin);
+    patch<std::uint64_t>(packet, timestamp_end_offset, timestamp_end);
+    patch<std::uint64_t>(packet, content_size_offset, packet.size() * 8);
+    patch<std::uint64_t>(packet, packet_size_offset, std::uint64_t{packet_size} * 8);
+
+    packet.resize(packet_size, '\0');
+    out.write(packet.data(), packet.size());
+    bytes_written += packet.size();
+
+    if (not out)
+      throw std::runtime_error("StreamWriter: failed to write packet");
+  }
+
+  boost::filesystem::ofstream out;
+  std::uint32_t cpu_id;
+  std::uint32_t packet_size;
+  std::string packet;
+  std::uint64_t timestamp_begin;
+  std::uint64_t timestamp_end;
+  std::uint64_t bytes_written;
+};
+
+// Writes all events of the given stream, returning its summary.
+ctf::generator::Summary generate_stream(const boost::filesystem::path& path, const ctf::generator::Shape& shape, std::uint32_t stream)
+{
+  StreamWriter writer{path, stream, shape.packet_size};
+  std::mt19937_64 rng{shape.seed ^ (std::uint64_t{stream} << 32)};
+  std::uniform_int_distribution<std::uint64_t> allocation_size{1, 4096};
+  std::uniform_int_distribution<std::int32_t> lock_status{0, 15};
+
+  const auto& pattern = pattern_of(shape.mix);
+  // Timestamps advance by the event period, streams are offset from each other to interleave.
+  const std::uint64_t period = std::max<std::uint64_t>(1, 1000000000 / std::max<std::uint64_t>(1, shape.events_per_second));
+  const std::uint64_t max_events = shape.events == 0 ? std::numeric_limits<std::uint64_t>::max() :
+      shape.events / shape.streams + (stream < shape.events % shape.streams ? 1 : 0);
+  const std::uint64_t max_bytes = shape.bytes == 0 ? std::numeric_limits<std::uint64_t>::max() :
+      shape.bytes / shape.streams;
+
+  std::string context, payload;
+  std::uint64_t events{0};
+
+  for (; events < max_events && writer.size() < max_bytes; events++)
+  {
+    // Processes own consecutive runs of events, with 4 threads each.
+    std::uint32_t process = static_cast<std::uint32_t>((events / 64 + stream) % shape.processes);
+    std::int32_t vpid = static_cast<std::int32_t>(1000 + process);
+    std::int32_t vtid = vpid + static_cast<std::int32_t>(events % 4);
+    std::string procname = "proc-" + std::to_string(process);
+    procname.resize(the_procname_length, '\0');
+    std::uint64_t ptr = 0x7f0000000000 + (std::uint64_t{process} << 32) + ((events / 2) << 4);
+    std::uint64_t mutex = 0x601000 + (std::uint64_t{process} << 6);
+
+    context.clear();
+    put<std::int32_t>(context, vpid);
+    put<std::int32_t>(context, vtid);
+    context.append(procname);
+    put<std::uint64_t>(context, 0x400000 + ((events * 16) & 0xffff));
+
+    EventId id = pattern[events % pattern.size()];
+    if (shape.mix == ctf::generator::Mix::mixed && events % the_soinfo_period == 0)
+      id = soinfo_id;
+
+    payload.clear();
+
+    switch (id)
+    {
+      case malloc_id:
+        put<std::uint64_t>(payload, allocation_size(rng));
+        put<std::uint64_t>(payload, ptr);
+        break;
+      case free_id:
+        put<std::uint64_t>(payload, ptr);
+        break;
+      case calloc_id:
+        put<std::uint64_t>(payload, allocation_size(rng) % 64 + 1);
+        put<std::uint64_t>(payload, allocation_size(rng) % 64 + 1);
+        put<std::uint64_t>(payload, ptr);
+        break;
+      case realloc_id:
+        put<std::uint64_t>(payload, ptr - 16);
+        put<std::uint64_t>(payload, allocation_size(rng));
+        put<std::uint64_t>(payload, ptr);
+        break;
+      case memalign_id:
+        put<std::uint64_t>(payload, 64);
+        put<std::uint64_t>(payload, allocation_size(rng));
+        put<std::uint64_t>(payload, ptr);
+        break;
+      case posix_memalign_id:
+        put<std::uint64_t>(payload, ptr);
+        put<std::uint64_t>(payload, 64);
+        put<std::uint64_t>(payload, allocation_size(rng));
+        put<std::int32_t>(payload, 0);
+        break;
+      case mutex_lock_req_id:
+        put<std::uint64_t>(payload, mutex);
+        break;
+      case mutex_lock_acq_id:
+      case mutex_unlock_id:
+        put<std::uint64_t>(payload, mutex);
+        put<std::int32_t>(payload, 0);
+        break;
+      case mutex_trylock_id:
+        put<std::uint64_t>(payload, mutex);
+        put<std::int32_t>(payload, lock_status(rng) == 0 ? 16 /* EBUSY */ : 0);
+        break;
+      case soinfo_id:
+        put<std::uint64_t>(payload, 0x7f1000000000 + ((events % 128) << 24));
+        put<std::uint64_t>(payload, 0x200000);
+        payload.append("/usr/lib/x86_64-linux-gnu/libgenerated-" + std::to_string(events % 128) + ".so.1");
+        payload.push_back('\0');
+        put<std::int64_t>(payload, 0x200000);
+        put<std::int64_t>(payload, the_clock_offset_s);
+        break;
+      case types_id:
+        {
+          // Every fourth callstack is empty.
+          auto depth = static_cast<std::uint32_t>(events % 4);
+          double ratio = events / 2.;
+          std::uint64_t ratio_bits;
+          std::memcpy(&ratio_bits, &ratio, sizeof(ratio_bits));
+
+          put<std::uint8_t>(payload, events % 3 == 0 ? 16 /* busy */ : 0 /* ok */);
+          put<std::uint32_t>(payload, depth);
+          for (std::uint32_t i = 0; i < depth; i++)
+            put<std::uint64_t>(payload, 0x400000 + 16 * i);
+          for (std::uint64_t i = 0; i < 4; i++)
+            put<std::uint8_t>(payload, events + i);
+          put<std::uint64_t>(payload, ratio_bits);
+        }
+        break;
+    }
+
+    writer.append(id, events * period + stream, context, payload);
+  }
+
+  return ctf::generator::Summary{events, writer.finish()};
+}
+}
+
+std::istream& ctf::generator::operator>>(std::istream& in, ctf::generator::Mix& mix)
+{
+  std::string s; in >> s;
+
+  if (s == "libc")
+    mix = ctf::generator::Mix::libc;
+  else if (s == "pthread")
+    mix = ctf::generator::Mix::pthread;
+  else if (s == "mixed")
+    mix = ctf::generator::Mix::mixed;
+  else if (s == "strings")
+    mix = ctf::generator::Mix::strings;
+  else if (s == "types")
+    mix = ctf::generator::Mix::types;
+  else
+    in.setstate(std::ios::failbit);
+
+  return in;
+}
+
+std::ostream& ctf::generator::operator<<(std::ostream& out, ctf::generator::Mix mix)
+{
+  switch (mix)
+  {
+    case ctf::generator::Mix::libc: out << "libc"; break;
+    case ctf::generator::Mix::pthread: out << "pthread"; break;
+    case ctf::generator::Mix::mixed: out << "mixed"; break;
+    case ctf::generator::Mix::strings: out << "strings"; break;
+    case ctf::generator::Mix::types: out << "types"; break;
+  }
+
+  return out;
+}
+
+ctf::generator::Shape ctf::generator::default_shape()
+{
+  return ctf::generator::Shape{1000000, 0, 4, 256 * 1024, 8, 1000000, 42, ctf::generator::Mix::mixed};
+}
+
+ctf::generator::Summary ctf::generator::generate(const boost::filesystem::path& dir, const ctf::generator::Shape& shape, unsigned int threads)
+{
+  if (shape.streams == 0 || shape.processes == 0)
+    throw std::runtime_error("generate: streams and processes must not be 0");
+
+  if (shape.events == 0 && shape.bytes == 0)
+    throw std::runtime_error("generate: either events or bytes must be limited");
+
+  boost::filesystem::create_directories(dir);
+
+  auto tsdl = metadata();
+  boost::filesystem::ofstream out{dir / "metadata", std::ios::trunc};
+  out << tsdl;
+  out.close();
+
+  if (not out)
+    throw std::runtime_error("generate: failed to write " + (dir / "metadata").string());
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, shape.streams);
+
+  // Workers pick streams until all of them have been generated. The first
+  // error is reported once all workers have finished.
+  std::atomic<std::uint32_t> next_stream{0};
+  std::atomic<std::uint64_t> events{0}, bytes{tsdl.size()};
+  std::exception_ptr error;
+  std::mutex guard;
+
+  auto worker = [&]()
+  {
+    for (auto stream = next_stream++; stream < shape.streams; stream = next_stream++)
+    {
+      try
+      {
+        auto summary = generate_stream(dir / ("channel0_" + std::to_string(stream)), shape, stream);
+        events += summary.events;
+        bytes += summary.bytes;
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lg{guard};
+        if (not error)
+          error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; i++)
+    workers.emplace_back(worker);
+
+  worker();
+
+  for (auto& w : workers)
+    w.join();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  return ctf::generator::Summary{events.load(), bytes.load()};
+}
@@ -0,0 +1,41 @@
+#include <lttng/histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+void lttng::Histogram::add(std::chrono::nanoseconds duration)
+{
+  std::uint64_t value = duration.count() > 0 ? duration.count() : 0;
+  std::size_t bucket{0};
+
+  // Index of the most significant bit of value + 1, saturating at the last bucket.
+  for (auto v = value + 1; v > 1 && bucket + 1 < buckets.size(); v >>= 1)
+    bucket++;
+
+  buckets[bucket]++;
+  count++;
+}
+
+std::chrono::nanoseconds lttng::Histogram::quantile(double q) const
+{
+  if (count == 0)
+    return std::chrono::nanoseconds{0};
+
+  auto rank = static_cast<std::uint64_t>(std::ceil(std::max(0., std::min(1., q)) * count));
+  std::uint64_t seen{0};
+
+  for (std::size_t i = 0; i < buckets.size(); i++)
+  {
+    seen += buckets[i];
+    if (seen < std::max<std::uint64_t>(rank, 1))
+      continue;
+
+    // The last bucket also holds all durations beyond its range.
+    if (i + 1 == buckets.size())
+      break;
+
+    return std::chrono::nanoseconds{static_cast<std::int64_t>((std::uint64_t{1} << (i + 1)) - 2)};
+  }
+
+  return std::chrono::nanoseconds::max();
+}
@@ -3,12 +3,26 @@
 
 #include <core/posix/exec.h>
 
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <linux/perf_event.h>
+
+#if defined(LTTNG_HAVE_LTTNG_CTL)
+#include <lttng/lttng-error.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
+#include <set>
 #include <sstream>
+#include <thread>
 
 namespace
 {
@@ -30,6 +44,254 @@ void throw_if_error(const core::posix::wait::Result& result)
     if (result.detail.if_exited.status != core::posix::exit::Status::success)
         throw std::runtime_error("The lttng executable exited with an error.");
 }
+
+std::string describe(int code)
+{
+#if defined(LTTNG_HAVE_LTTNG_CTL)
+    return lttng_strerror(code);
+#else
+    return "lttng error " + boost::lexical_cast<std::string>(code);
+#endif
+}
+
+// Returns the name lttng add-context knows the given counter by in the given domain, e.g., perf:thread:cpu-cycles.
+std::string perf_context_name(lttng::Domain domain, lttng::PerfCounter counter)
+{
+    return (domain == lttng::Domain::kernel ? "perf:cpu:" : "perf:thread:") + boost::lexical_cast<std::string>(counter);
+}
+
+// Returns the directories immediately below the given path.
+std::set<boost::filesystem::path> subdirectories(const boost::filesystem::path& path)
+{
+    std::set<boost::filesystem::path> result;
+
+    for (boost::filesystem::directory_iterator it{path}, itE; it != itE; ++it)
+        if (boost::filesystem::is_directory(it->status()))
+            result.insert(it->path());
+
+    return result;
+}
+
+// Runs f on a thread of its own, posting handler with the outcome of f to the given io_service.
+void run_and_post(boost::asio::io_service& io_service, const std::function<void()>& f, const lttng::Session::CompletionHandler& handler)
+{
+    // Keeps io_service from running out of work before handler has been posted.
+    auto work = std::make_shared<boost::asio::io_service::work>(io_service);
+
+    std::thread{[&io_service, work, f, handler]()
+    {
+        std::exception_ptr ep;
+
+        try
+        {
+            f();
+        }
+        catch (...)
+        {
+            ep = std::current_exception();
+        }
+
+        io_service.post([handler, ep]() { handler(ep); });
+    }}.detach();
+}
+
+// Runs create on a thread of its own, posting handler with the created session to the given io_service.
+void create_and_post(
+        boost::asio::io_service& io_service,
+        const std::function<std::shared_ptr<lttng::Session>()>& create,
+        const lttng::Tracer::SessionHandler& handler)
+{
+    auto session = std::make_shared<std::shared_ptr<lttng::Session>>();
+
+    run_and_post(io_service, [session, create]() { *session = create(); }, [session, handler](std::exception_ptr ep)
+    {
+        handler(ep, *session);
+    });
+}
+
+// ExecControlBackend runs the lttng command line client for every operation.
+class ExecControlBackend : public lttng::ControlBackend
+{
+public:
+    explicit ExecControlBackend(const boost::filesystem::path& lttng) : lttng(lttng)
+    {
+    }
+
+protected:
+    void do_create_session(const std::string& name, const std::string& url) override
+    {
+        run({"create", name, "--set-url", url});
+    }
+
+    void do_create_snapshot_session(const std::string& name, const std::string& url) override
+    {
+        run({"create", name, "--snapshot", "--set-url", url});
+    }
+
+    void do_destroy_session(const std::string& name) override
+    {
+        run({"destroy", name});
+    }
+
+    void do_enable_channel(const std::string& session, lttng::Domain domain, const lttng::Channel& channel) override
+    {
+        std::vector<std::string> argv
+        {
+            "enable-channel", channel.name, "--" + boost::lexical_cast<std::string>(domain), "-s", session,
+            "--subbuf-size", boost::lexical_cast<std::string>(channel.subbuffer_size),
+            "--num-subbuf", boost::lexical_cast<std::string>(channel.subbuffer_count),
+            channel.mode == lttng::Channel::Mode::overwrite ? "--overwrite" : "--discard",
+            "--output", boost::lexical_cast<std::string>(channel.output),
+            "--switch-timer", boost::lexical_cast<std::string>(channel.switch_timer.count()),
+            "--read-timer", boost::lexical_cast<std::string>(channel.read_timer.count()),
+            "--tracefile-size", boost::lexical_cast<std::string>(channel.tracefile_size),
+            "--tracefile-count", boost::lexical_cast<std::string>(channel.tracefile_count)
+        };
+
+        switch (channel.buffers)
+        {
+        case lttng::Channel::Buffers::per_uid: argv.push_back("--buffers-uid"); break;
+        case lttng::Channel::Buffers::per_pid: argv.push_back("--buffers-pid"); break;
+        case lttng::Channel::Buffers::global: argv.push_back("--buffers-global"); break;
+        }
+
+        if (channel.monitor_timer)
+        {
+            argv.push_back("--monitor-timer");
+            argv.push_back(boost::lexical_cast<std::string>(channel.monitor_timer->count()));
+        }
+
+        run(argv);
+    }
+
+    void do_add_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::Context context) override
+    {
+        std::vector<std::string> argv
+        {
+            "add-context", "-t", boost::lexical_cast<std::string>(context), "--" + boost::lexical_cast<std::string>(domain), "-s", session
+        };
+
+        if (not channel.empty())
+        {
+            argv.push_back("-c");
+            argv.push_back(channel);
+        }
+
+        run(argv);
+    }
+
+    void do_add_perf_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::PerfCounter counter) override
+    {
+        std::vector<std::string> argv
+        {
+            "add-context", "-t", perf_context_name(domain, counter), "--" + boost::lexical_cast<std::string>(domain), "-s", session
+        };
+
+        if (not channel.empty())
+        {
+            argv.push_back("-c");
+            argv.push_back(channel);
+        }
+
+        run(argv);
+    }
+
+    void do_enable_event(const std::string& session, lttng::Domain domain, const std::string& channel, const lttng::EventRule& rule) override
+    {
+        std::vector<std::string> argv{"enable-event", rule.name, "--" + boost::lexical_cast<std::string>(domain), "-s", session};
+
+        if (not channel.empty())
+        {
+            argv.push_back("-c");
+            argv.push_back(channel);
+        }
+
+        if (not rule.filter.empty())
+        {
+            argv.push_back("--filter");
+            argv.push_back(rule.filter);
+        }
+
+        switch (rule.log_level_match)
+        {
+        case lttng::EventRule::LogLevelMatch::all: break;
+        case lttng::EventRule::LogLevelMatch::range: argv.push_back("--loglevel=" + boost::lexical_cast<std::string>(rule.log_level)); break;
+        case lttng::EventRule::LogLevelMatch::single: argv.push_back("--loglevel-only=" + boost::lexical_cast<std::string>(rule.log_level)); break;
+        }
+
+        if (not rule.exclusions.empty())
+            argv.push_back("--exclude=" + boost::algorithm::join(rule.exclusions, ","));
+
+        run(argv);
+    }
+
+    void do_start(const std::string& session) override
+    {
+        run({"start", session});
+    }
+
+    void do_stop(const std::string& session) override
+    {
+        run({"stop", session}, core::posix::StandardStream::stdout);
+    }
+
+    void do_record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url) override
+    {
+        run({"snapshot", "record", "-s", session, "-n", snapshot, url});
+    }
+
+    void do_load_session(const std::string& name, const boost::filesystem::path& file) override
+    {
+        run({"load", "--input-path", file.native(), name});
+    }
+
+    void do_rotate(const std::string& session) override
+    {
+        run({"rotate", session}, core::posix::StandardStream::stdout);
+    }
+
+    void do_enable_rotation(const std::string& session, const lttng::RotationSchedule& schedule) override
+    {
+        run(rotation_argv("enable-rotation", session, schedule, true));
+    }
+
+    void do_disable_rotation(const std::string& session, const lttng::RotationSchedule& schedule) override
+    {
+        run(rotation_argv("disable-rotation", session, schedule, false));
+    }
+
+private:
+    // Assembles the arguments of enable-rotation and disable-rotation, which only take values when enabling.
+    static std::vector<std::string> rotation_argv(
+            const std::string& command, const std::string& session, const lttng::RotationSchedule& schedule, bool with_values)
+    {
+        std::vector<std::string> argv{command, "-s", session};
+
+        if (schedule.period)
+        {
+            argv.push_back("--timer");
+            if (with_values)
+                argv.push_back(boost::lexical_cast<std::string>(schedule.period->count()));
+        }
+
+        if (schedule.size)
+        {
+            argv.push_back("--size");
+            if (with_values)
+                argv.push_back(boost::lexical_cast<std::string>(*schedule.size));
+        }
+
+        return argv;
+    }
+
+    void run(const std::vector<std::string>& argv, core::posix::StandardStream flags = core::posix::StandardStream::empty)
+    {
+        auto cp = core::posix::exec(lttng.native(), argv, copy_env(), flags);
+        throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+    }
+
+    boost::filesystem::path lttng;
+};
 }
 
 std::ostream& lttng::operator<<(std::ostream& out, lttng::Domain domain)
@@ -64,24 +326,589 @@ std::ostream& lttng::operator<<(std::ostream& out, lttng::Context context)
     return out;
 }
 
+std::ostream& lttng::operator<<(std::ostream& out, lttng::PerfCounter counter)
+{
+    switch (counter)
+    {
+    case lttng::PerfCounter::cpu_cycles: out << "cpu-cycles"; break;
+    case lttng::PerfCounter::instructions: out << "instructions"; break;
+    case lttng::PerfCounter::cache_references: out << "cache-references"; break;
+    case lttng::PerfCounter::cache_misses: out << "cache-misses"; break;
+    case lttng::PerfCounter::branch_instructions: out << "branch-instructions"; break;
+    case lttng::PerfCounter::branch_misses: out << "branch-misses"; break;
+    case lttng::PerfCounter::bus_cycles: out << "bus-cycles"; break;
+    case lttng::PerfCounter::stalled_cycles_frontend: out << "stalled-cycles-frontend"; break;
+    case lttng::PerfCounter::stalled_cycles_backend: out << "stalled-cycles-backend"; break;
+    case lttng::PerfCounter::cpu_clock: out << "cpu-clock"; break;
+    case lttng::PerfCounter::task_clock: out << "task-clock"; break;
+    case lttng::PerfCounter::page_faults: out << "page-fault"; break;
+    case lttng::PerfCounter::context_switches: out << "context-switches"; break;
+    case lttng::PerfCounter::cpu_migrations: out << "cpu-migrations"; break;
+    case lttng::PerfCounter::minor_faults: out << "minor-faults"; break;
+    case lttng::PerfCounter::major_faults: out << "major-faults"; break;
+    }
+
+    return out;
+}
+
+lttng::PerfEventConfig lttng::perf_event_config(lttng::PerfCounter counter)
+{
+    switch (counter)
+    {
+    case lttng::PerfCounter::cpu_cycles: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    case lttng::PerfCounter::instructions: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+    case lttng::PerfCounter::cache_references: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES};
+    case lttng::PerfCounter::cache_misses: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+    case lttng::PerfCounter::branch_instructions: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS};
+    case lttng::PerfCounter::branch_misses: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+    case lttng::PerfCounter::bus_cycles: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES};
+    case lttng::PerfCounter::stalled_cycles_frontend: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND};
+    case lttng::PerfCounter::stalled_cycles_backend: return lttng::PerfEventConfig{PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND};
+    case lttng::PerfCounter::cpu_clock: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK};
+    case lttng::PerfCounter::task_clock: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK};
+    case lttng::PerfCounter::page_faults: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS};
+    case lttng::PerfCounter::context_switches: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES};
+    case lttng::PerfCounter::cpu_migrations: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS};
+    case lttng::PerfCounter::minor_faults: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN};
+    case lttng::PerfCounter::major_faults: return lttng::PerfEventConfig{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ};
+    }
+
+    throw std::runtime_error("perf_event_config: unknown counter");
+}
+
+std::string lttng::perf_field_name(lttng::Domain domain, lttng::PerfCounter counter)
+{
+    // lttng derives field names from context names, e.g., perf:thread:cpu-cycles becomes perf_thread_cpu_cycles.
+    auto name = perf_context_name(domain, counter);
+    std::replace_if(name.begin(), name.end(), [](char c) { return c == ':' || c == '-'; }, '_');
+    return name;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::LogLevel level)
+{
+    switch (level)
+    {
+    case lttng::LogLevel::emergency: out << "TRACE_EMERG"; break;
+    case lttng::LogLevel::alert: out << "TRACE_ALERT"; break;
+    case lttng::LogLevel::critical: out << "TRACE_CRIT"; break;
+    case lttng::LogLevel::error: out << "TRACE_ERR"; break;
+    case lttng::LogLevel::warning: out << "TRACE_WARNING"; break;
+    case lttng::LogLevel::notice: out << "TRACE_NOTICE"; break;
+    case lttng::LogLevel::info: out << "TRACE_INFO"; break;
+    case lttng::LogLevel::debug_system: out << "TRACE_DEBUG_SYSTEM"; break;
+    case lttng::LogLevel::debug_program: out << "TRACE_DEBUG_PROGRAM"; break;
+    case lttng::LogLevel::debug_process: out << "TRACE_DEBUG_PROCESS"; break;
+    case lttng::LogLevel::debug_module: out << "TRACE_DEBUG_MODULE"; break;
+    case lttng::LogLevel::debug_unit: out << "TRACE_DEBUG_UNIT"; break;
+    case lttng::LogLevel::debug_function: out << "TRACE_DEBUG_FUNCTION"; break;
+    case lttng::LogLevel::debug_line: out << "TRACE_DEBUG_LINE"; break;
+    case lttng::LogLevel::debug: out << "TRACE_DEBUG"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::EventRule::LogLevelMatch match)
+{
+    switch (match)
+    {
+    case lttng::EventRule::LogLevelMatch::all: out << "all"; break;
+    case lttng::EventRule::LogLevelMatch::range: out << "range"; break;
+    case lttng::EventRule::LogLevelMatch::single: out << "single"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::Channel::Mode mode)
+{
+    switch (mode)
+    {
+    case lttng::Channel::Mode::discard: out << "discard"; break;
+    case lttng::Channel::Mode::overwrite: out << "overwrite"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::Channel::Buffers buffers)
+{
+    switch (buffers)
+    {
+    case lttng::Channel::Buffers::per_uid: out << "per_uid"; break;
+    case lttng::Channel::Buffers::per_pid: out << "per_pid"; break;
+    case lttng::Channel::Buffers::global: out << "global"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::Channel::Output output)
+{
+    switch (output)
+    {
+    case lttng::Channel::Output::mmap: out << "mmap"; break;
+    case lttng::Channel::Output::splice: out << "splice"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::SessionMode mode)
+{
+    switch (mode)
+    {
+    case lttng::SessionMode::regular: out << "regular"; break;
+    case lttng::SessionMode::snapshot: out << "snapshot"; break;
+    }
+
+    return out;
+}
+
+std::ostream& lttng::operator<<(std::ostream& out, lttng::Command command)
+{
+    switch (command)
+    {
+    case lttng::Command::create_session: out << "create_session"; break;
+    case lttng::Command::create_snapshot_session: out << "create_snapshot_session"; break;
+    case lttng::Command::destroy_session: out << "destroy_session"; break;
+    case lttng::Command::enable_channel: out << "enable_channel"; break;
+    case lttng::Command::add_context: out << "add_context"; break;
+    case lttng::Command::enable_event: out << "enable_event"; break;
+    case lttng::Command::start: out << "start"; break;
+    case lttng::Command::stop: out << "stop"; break;
+    case lttng::Command::record_snapshot: out << "record_snapshot"; break;
+    case lttng::Command::load_session: out << "load_session"; break;
+    case lttng::Command::rotate: out << "rotate"; break;
+    case lttng::Command::enable_rotation: out << "enable_rotation"; break;
+    case lttng::Command::disable_rotation: out << "disable_rotation"; break;
+    }
+
+    return out;
+}
+
+lttng::EventRule::EventRule(const std::string& name)
+    : name(name),
+      log_level_match(lttng::EventRule::LogLevelMatch::all),
+      log_level(lttng::LogLevel::debug)
+{
+}
+
+lttng::Channel lttng::Channel::defaults(lttng::Domain domain, const std::string& name)
+{
+    // Mirrors the defaults of lttng enable-channel.
+    switch (domain)
+    {
+    case lttng::Domain::kernel:
+        return lttng::Channel
+        {
+            name, 1048576, 4, lttng::Channel::Mode::discard, lttng::Channel::Buffers::global, lttng::Channel::Output::splice,
+            std::chrono::microseconds{0}, std::chrono::microseconds{200000}, boost::none, 0, 0
+        };
+    case lttng::Domain::userspace:
+        break;
+    }
+
+    return lttng::Channel
+    {
+        name, 524288, 4, lttng::Channel::Mode::discard, lttng::Channel::Buffers::per_uid, lttng::Channel::Output::mmap,
+        std::chrono::microseconds{0}, std::chrono::microseconds{0}, boost::none, 0, 0
+    };
+}
+
+lttng::RotationSchedule lttng::RotationSchedule::every(std::chrono::microseconds period)
+{
+    return lttng::RotationSchedule{period, boost::none};
+}
+
+lttng::RotationSchedule lttng::RotationSchedule::larger_than(std::uint64_t size)
+{
+    return lttng::RotationSchedule{boost::none, size};
+}
+
 lttng::Exception::Exception(int code) noexcept(true)
-    : std::runtime_error(""),
+    : std::runtime_error(describe(code)),
       code(code)
 {
 }
 
-std::unique_ptr<lttng::Tracer> lttng::Tracer::create(lttng::Domain domain)
+std::shared_ptr<lttng::ControlBackend> lttng::ControlBackend::exec(const boost::filesystem::path& lttng)
+{
+    return std::make_shared<ExecControlBackend>(lttng);
+}
+
+#if !defined(LTTNG_HAVE_LTTNG_CTL)
+std::shared_ptr<lttng::ControlBackend> lttng::ControlBackend::lttng_ctl()
+{
+    throw std::runtime_error("ControlBackend::lttng_ctl: built without liblttng-ctl");
+}
+#endif
+
+std::shared_ptr<lttng::ControlBackend> lttng::ControlBackend::default_backend()
+{
+#if defined(LTTNG_HAVE_LTTNG_CTL)
+    return lttng_ctl();
+#else
+    return exec();
+#endif
+}
+
+void lttng::ControlBackend::create_session(const std::string& name, const std::string& url)
+{
+    measure(lttng::Command::create_session, [&]() { do_create_session(name, url); });
+}
+
+void lttng::ControlBackend::create_snapshot_session(const std::string& name, const std::string& url)
+{
+    measure(lttng::Command::create_snapshot_session, [&]() { do_create_snapshot_session(name, url); });
+}
+
+void lttng::ControlBackend::destroy_session(const std::string& name)
+{
+    measure(lttng::Command::destroy_session, [&]() { do_destroy_session(name); });
+}
+
+void lttng::ControlBackend::enable_channel(const std::string& session, lttng::Domain domain, const lttng::Channel& channel)
+{
+    measure(lttng::Command::enable_channel, [&]() { do_enable_channel(session, domain, channel); });
+}
+
+void lttng::ControlBackend::add_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::Context context)
+{
+    measure(lttng::Command::add_context, [&]() { do_add_context(session, domain, channel, context); });
+}
+
+void lttng::ControlBackend::add_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::PerfCounter counter)
+{
+    measure(lttng::Command::add_context, [&]() { do_add_perf_context(session, domain, channel, counter); });
+}
+
+void lttng::ControlBackend::enable_event(const std::string& session, lttng::Domain domain, const std::string& channel, const lttng::EventRule& rule)
+{
+    measure(lttng::Command::enable_event, [&]() { do_enable_event(session, domain, channel, rule); });
+}
+
+void lttng::ControlBackend::start(const std::string& session)
+{
+    measure(lttng::Command::start, [&]() { do_start(session); });
+}
+
+void lttng::ControlBackend::stop(const std::string& session)
 {
-    return std::unique_ptr<lttng::Tracer>(new lttng::Tracer(domain));
+    measure(lttng::Command::stop, [&]() { do_stop(session); });
 }
 
-lttng::Tracer::Tracer(lttng::Domain domain) : domain{domain}
+void lttng::ControlBackend::record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url)
+{
+    measure(lttng::Command::record_snapshot, [&]() { do_record_snapshot(session, snapshot, url); });
+}
+
+void lttng::ControlBackend::load_session(const std::string& name, const boost::filesystem::path& file)
+{
+    measure(lttng::Command::load_session, [&]() { do_load_session(name, file); });
+}
+
+void lttng::ControlBackend::rotate(const std::string& session)
+{
+    measure(lttng::Command::rotate, [&]() { do_rotate(session); });
+}
+
+void lttng::ControlBackend::enable_rotation(const std::string& session, const lttng::RotationSchedule& schedule)
+{
+    measure(lttng::Command::enable_rotation, [&]() { do_enable_rotation(session, schedule); });
+}
+
+void lttng::ControlBackend::disable_rotation(const std::string& session, const lttng::RotationSchedule& schedule)
+{
+    measure(lttng::Command::disable_rotation, [&]() { do_disable_rotation(session, schedule); });
+}
+
+lttng::ControlBackend::Metrics lttng::ControlBackend::metrics() const
+{
+    std::lock_guard<std::mutex> lg{guard};
+    return metrics_;
+}
+
+void lttng::ControlBackend::reset_metrics()
+{
+    std::lock_guard<std::mutex> lg{guard};
+    metrics_.clear();
+}
+
+void lttng::ControlBackend::measure(lttng::Command command, const std::function<void()>& f)
+{
+    bool failed{true};
+    auto start = std::chrono::steady_clock::now();
+
+    // Accounts for the invocation on all paths out of this function.
+    struct Scope
+    {
+        ~Scope()
+        {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+            std::lock_guard<std::mutex> lg{backend.guard};
+            auto& m = backend.metrics_[command];
+            m.calls++;
+            m.failures += failed ? 1 : 0;
+            m.total += elapsed;
+            m.latency.add(elapsed);
+        }
+
+        lttng::ControlBackend& backend;
+        lttng::Command command;
+        std::chrono::steady_clock::time_point start;
+        const bool& failed;
+    } scope{*this, command, start, failed};
+
+    f();
+    failed = false;
+}
+
+std::vector<lttng::RecordingControlBackend::Call> lttng::RecordingControlBackend::calls() const
+{
+    std::lock_guard<std::mutex> lg{guard};
+    return calls_;
+}
+
+void lttng::RecordingControlBackend::fail(lttng::Command command, int code)
+{
+    std::lock_guard<std::mutex> lg{guard};
+    failures[command] = code;
+}
+
+void lttng::RecordingControlBackend::do_create_session(const std::string& name, const std::string& url)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::create_session, name, {url}});
+
+    std::lock_guard<std::mutex> lg{guard};
+    urls[name] = url;
+}
+
+void lttng::RecordingControlBackend::do_create_snapshot_session(const std::string& name, const std::string& url)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::create_snapshot_session, name, {url}});
+
+    std::lock_guard<std::mutex> lg{guard};
+    urls[name] = url;
+}
+
+void lttng::RecordingControlBackend::do_destroy_session(const std::string& name)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::destroy_session, name, {}});
+}
+
+void lttng::RecordingControlBackend::do_enable_channel(const std::string& session, lttng::Domain domain, const lttng::Channel& channel)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::enable_channel, session,
+        {
+            boost::lexical_cast<std::string>(domain),
+            channel.name,
+            boost::lexical_cast<std::string>(channel.subbuffer_size),
+            boost::lexical_cast<std::string>(channel.subbuffer_count),
+            boost::lexical_cast<std::string>(channel.mode),
+            boost::lexical_cast<std::string>(channel.buffers),
+            boost::lexical_cast<std::string>(channel.output)
+        }
+    });
+}
+
+void lttng::RecordingControlBackend::do_add_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::Context context)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::add_context, session,
+        {boost::lexical_cast<std::string>(domain), channel, boost::lexical_cast<std::string>(context)}
+    });
+}
+
+void lttng::RecordingControlBackend::do_add_perf_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::PerfCounter counter)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::add_context, session,
+        {boost::lexical_cast<std::string>(domain), channel, perf_context_name(domain, counter)}
+    });
+}
+
+void lttng::RecordingControlBackend::do_enable_event(const std::string& session, lttng::Domain domain, const std::string& channel, const lttng::EventRule& rule)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::enable_event, session,
+        {
+            boost::lexical_cast<std::string>(domain),
+            channel,
+            rule.name,
+            rule.filter,
+            boost::lexical_cast<std::string>(rule.log_level_match),
+            boost::lexical_cast<std::string>(rule.log_level),
+            boost::algorithm::join(rule.exclusions, ",")
+        }
+    });
+}
+
+void lttng::RecordingControlBackend::do_start(const std::string& session)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::start, session, {}});
+}
+
+void lttng::RecordingControlBackend::do_stop(const std::string& session)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::stop, session, {}});
+}
+
+void lttng::RecordingControlBackend::do_record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::record_snapshot, session, {snapshot, url}});
+
+    // Mirror the layout of lttng, creating an empty snapshot directory for local urls.
+    if (boost::algorithm::starts_with(url, "file://"))
+        boost::filesystem::create_directories(boost::filesystem::path{url.substr(std::strlen("file://"))} / (snapshot + "-0"));
+}
+
+void lttng::RecordingControlBackend::do_load_session(const std::string& name, const boost::filesystem::path& file)
+{
+    // The file is gone once loading completes, we thus record the session description itself.
+    boost::filesystem::ifstream in{file};
+    std::string description{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    record(lttng::RecordingControlBackend::Call{lttng::Command::load_session, name, {description}});
+}
+
+void lttng::RecordingControlBackend::do_rotate(const std::string& session)
+{
+    record(lttng::RecordingControlBackend::Call{lttng::Command::rotate, session, {}});
+
+    // Mirror the layout of lttng, creating an empty chunk directory for sessions created with a local url.
+    std::lock_guard<std::mutex> lg{guard};
+    auto url = urls.find(session);
+    if (url == urls.end() || not boost::algorithm::starts_with(url->second, "file://"))
+        return;
+
+    auto chunks = std::count_if(calls_.begin(), calls_.end(), [&session](const lttng::RecordingControlBackend::Call& call)
+    {
+        return call.command == lttng::Command::rotate && call.session == session;
+    });
+
+    boost::filesystem::create_directories(
+                boost::filesystem::path{url->second.substr(std::strlen("file://"))} / "archives" /
+                (session + "-chunk-" + boost::lexical_cast<std::string>(chunks)));
+}
+
+void lttng::RecordingControlBackend::do_enable_rotation(const std::string& session, const lttng::RotationSchedule& schedule)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::enable_rotation, session,
+        {
+            schedule.period ? boost::lexical_cast<std::string>(schedule.period->count()) : std::string{},
+            schedule.size ? boost::lexical_cast<std::string>(*schedule.size) : std::string{}
+        }
+    });
+}
+
+void lttng::RecordingControlBackend::do_disable_rotation(const std::string& session, const lttng::RotationSchedule& schedule)
+{
+    record(lttng::RecordingControlBackend::Call
+    {
+        lttng::Command::disable_rotation, session,
+        {
+            schedule.period ? boost::lexical_cast<std::string>(schedule.period->count()) : std::string{},
+            schedule.size ? boost::lexical_cast<std::string>(*schedule.size) : std::string{}
+        }
+    });
+}
+
+void lttng::RecordingControlBackend::record(const lttng::RecordingControlBackend::Call& call)
+{
+    std::lock_guard<std::mutex> lg{guard};
+    calls_.push_back(call);
+
+    auto it = failures.find(call.command);
+    if (it != failures.end())
+        throw lttng::Exception(it->second);
+}
+
+std::unique_ptr<lttng::Tracer> lttng::Tracer::create(lttng::Domain domain, const std::shared_ptr<lttng::ControlBackend>& backend)
+{
+    return std::unique_ptr<lttng::Tracer>(new lttng::Tracer(domain, backend));
+}
+
+lttng::Tracer::Tracer(lttng::Domain domain, const std::shared_ptr<lttng::ControlBackend>& backend) : domain{domain}, backend{backend}
 {
 }
 
 std::shared_ptr<lttng::Session> lttng::Tracer::create_session(const std::string& name, const std::shared_ptr<lttng::Consumer>& consumer)
 {
-    return std::make_shared<lttng::Session>(domain, name, consumer);
+    return std::make_shared<lttng::Session>(domain, name, consumer, backend);
+}
+
+std::shared_ptr<lttng::Session> lttng::Tracer::create_session(
+        const std::string& name,
+        const std::shared_ptr<lttng::Consumer>& consumer,
+        lttng::SessionMode mode)
+{
+    return std::make_shared<lttng::Session>(domain, name, consumer, mode, backend);
+}
+
+std::shared_ptr<lttng::Session> lttng::Tracer::create_session(const lttng::SessionConfig& config)
+{
+    if (config.domain() != domain)
+        throw std::runtime_error("Tracer::create_session: configuration targets a different domain");
+
+    return std::make_shared<lttng::Session>(config, backend);
+}
+
+std::future<std::shared_ptr<lttng::Session>> lttng::Tracer::async_create_session(const std::string& name, const std::shared_ptr<lttng::Consumer>& consumer)
+{
+    auto domain = this->domain; auto backend = this->backend;
+    return std::async(std::launch::async, [domain, backend, name, consumer]()
+    {
+        return std::make_shared<lttng::Session>(domain, name, consumer, backend);
+    });
+}
+
+void lttng::Tracer::async_create_session(
+        boost::asio::io_service& io_service,
+        const std::string& name,
+        const std::shared_ptr<lttng::Consumer>& consumer,
+        const lttng::Tracer::SessionHandler& handler)
+{
+    auto domain = this->domain; auto backend = this->backend;
+    create_and_post(io_service, [domain, backend, name, consumer]()
+    {
+        return std::make_shared<lttng::Session>(domain, name, consumer, backend);
+    }, handler);
+}
+
+std::future<std::shared_ptr<lttng::Session>> lttng::Tracer::async_create_session(const lttng::SessionConfig& config)
+{
+    if (config.domain() != domain)
+        throw std::runtime_error("Tracer::async_create_session: configuration targets a different domain");
+
+    auto backend = this->backend;
+    return std::async(std::launch::async, [backend, config]()
+    {
+        return std::make_shared<lttng::Session>(config, backend);
+    });
+}
+
+void lttng::Tracer::async_create_session(
+        boost::asio::io_service& io_service,
+        const lttng::SessionConfig& config,
+        const lttng::Tracer::SessionHandler& handler)
+{
+    if (config.domain() != domain)
+        throw std::runtime_error("Tracer::async_create_session: configuration targets a different domain");
+
+    auto backend = this->backend;
+    create_and_post(io_service, [backend, config]()
+    {
+        return std::make_shared<lttng::Session>(config, backend);
+    }, handler);
 }
 
 lttng::FileSystemConsumer::FileSystemConsumer(const boost::filesystem::path& path) : path_(path)
@@ -104,25 +931,183 @@ std::string lttng::FileSystemConsumer::to_url() const
     return "file://" + path_.native();
 }
 
-lttng::Session::Session(lttng::Domain domain, const std::string& name, const std::shared_ptr<lttng::Consumer>& consumer) 
+// ChunkWatcher polls the archive directory of a session, handing every new chunk to a ChunkHandler.
+class lttng::Session::ChunkWatcher
+{
+public:
+    ChunkWatcher(
+            const boost::filesystem::path& archives,
+            const lttng::Session::ChunkHandler& handler,
+            bool remove_handled,
+            std::chrono::milliseconds poll_interval)
+        : archives(archives),
+          handler(handler),
+          remove_handled(remove_handled),
+          poll_interval(poll_interval),
+          stopped(false),
+          worker{[this]() { run(); }}
+    {
+    }
+
+    ~ChunkWatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lg{guard};
+            stopped = true;
+        }
+
+        wakeup.notify_all();
+        worker.join();
+    }
+
+    // Keeps the watcher from scanning for the lifetime of the returned lock.
+    std::unique_lock<std::mutex> hold()
+    {
+        return std::unique_lock<std::mutex>{scanning};
+    }
+
+    // Keeps the given chunk on disk after handing it over. Only to be called while holding the watcher.
+    void keep(const boost::filesystem::path& chunk)
+    {
+        kept.insert(chunk);
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> ul{guard};
+
+        while (not wakeup.wait_for(ul, poll_interval, [this]() { return stopped; }))
+        {
+            ul.unlock();
+            try_scan();
+            ul.lock();
+        }
+
+        // Hand over chunks archived since the last scan, e.g., by a final rotation.
+        ul.unlock();
+        try_scan();
+    }
+
+    // Scans the archive directory, leaving errors accessing it to be retried by the next scan.
+    void try_scan()
+    {
+        try
+        {
+            scan();
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    // Hands all chunks not seen before to the handler. lttng only moves a chunk to the
+    // archive directory once it is complete, and names it after its begin time, such
+    // that the order of names is the order of recording.
+    void scan()
+    {
+        std::lock_guard<std::mutex> lg{scanning};
+
+        if (not boost::filesystem::exists(archives))
+            return;
+
+        for (const auto& chunk : subdirectories(archives))
+        {
+            if (not seen.insert(chunk).second)
+                continue;
+
+            try
+            {
+                ctf::Trace trace{chunk};
+                handler(trace, chunk);
+            }
+            catch (...)
+            {
+                // Chunks that fail to open or to be handled are kept for inspection.
+                continue;
+            }
+
+            if (remove_handled && kept.count(chunk) == 0)
+            {
+                boost::system::error_code ec; boost::filesystem::remove_all(chunk, ec);
+            }
+        }
+    }
+
+    boost::filesystem::path archives;
+    lttng::Session::ChunkHandler handler;
+    bool remove_handled;
+    std::chrono::milliseconds poll_interval;
+    std::set<boost::filesystem::path> seen; ///< All chunks handed to the handler so far.
+    std::set<boost::filesystem::path> kept; ///< Chunks returned by Session::rotate, never removed.
+    std::mutex scanning; ///< Serializes scans with rotations.
+    std::mutex guard;
+    std::condition_variable wakeup;
+    bool stopped;
+    std::thread worker;
+};
+
+lttng::Session::Session(
+        lttng::Domain domain,
+        const std::string& name,
+        const std::shared_ptr<lttng::Consumer>& consumer,
+        const std::shared_ptr<lttng::ControlBackend>& backend)
+    : Session(domain, name, consumer, lttng::SessionMode::regular, backend)
+{
+}
+
+lttng::Session::Session(
+        lttng::Domain domain,
+        const std::string& name,
+        const std::shared_ptr<lttng::Consumer>& consumer,
+        lttng::SessionMode mode,
+        const std::shared_ptr<lttng::ControlBackend>& backend)
     : domain_(domain),
       name_(name),
-      consumer_(consumer)
+      mode_(mode),
+      consumer_(consumer),
+      backend_(backend),
+      snapshots_(0)
+{
+    switch (mode_)
+    {
+    case lttng::SessionMode::regular:
+        backend_->create_session(name_, consumer->to_url());
+        break;
+    case lttng::SessionMode::snapshot:
+        backend_->create_snapshot_session(name_, consumer->to_url());
+        break;
+    }
+}
+
+lttng::Session::Session(const lttng::SessionConfig& config, const std::shared_ptr<lttng::ControlBackend>& backend)
+    : domain_(config.domain()),
+      name_(config.name()),
+      mode_(lttng::SessionMode::regular),
+      consumer_(config.consumer()),
+      backend_(backend),
+      snapshots_(0)
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"create", name_, "--set-url", consumer->to_url()},
-                copy_env(), core::posix::StandardStream::empty);
+    auto file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-session-%%%%-%%%%.lttng");
+    config.save(file);
+
+    try
+    {
+        backend_->load_session(name_, file);
+    }
+    catch (...)
+    {
+        boost::system::error_code ec; boost::filesystem::remove(file, ec);
+        throw;
+    }
 
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+    boost::system::error_code ec; boost::filesystem::remove(file, ec);
 }
 
 lttng::Session::~Session()
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"destroy", name_},
-                copy_env(), core::posix::StandardStream::empty);
-
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+    chunk_watcher_.reset();
+    backend_->destroy_session(name_);
 }
 
 const std::string& lttng::Session::name() const
@@ -130,37 +1115,167 @@ const std::string& lttng::Session::name() const
     return name_;
 }
 
+lttng::SessionMode lttng::Session::mode() const
+{
+    return mode_;
+}
+
+void lttng::Session::enable_channel(const lttng::Channel& channel)
+{
+    backend_->enable_channel(name_, domain_, channel);
+}
+
 void lttng::Session::add_context(lttng::Context context)
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"add-context", "-t", boost::lexical_cast<std::string>(context), "--" + boost::lexical_cast<std::string>(domain_), "-s", name_},
-                copy_env(), core::posix::StandardStream::empty);
+    add_context(context, std::string{});
+}
 
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+void lttng::Session::add_context(lttng::Context context, const std::string& channel)
+{
+    backend_->add_context(name_, domain_, channel, context);
+}
+
+void lttng::Session::add_context(lttng::PerfCounter counter, const std::string& channel)
+{
+    backend_->add_context(name_, domain_, channel, counter);
 }
 
 void lttng::Session::enable_event(const std::string& event)
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"enable-event", event, "--" + boost::lexical_cast<std::string>(domain_), "-s", name_},
-                copy_env(), core::posix::StandardStream::empty);
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+    enable_event(event, std::string{});
 }
 
-void lttng::Session::start()
+void lttng::Session::enable_event(const std::string& event, const std::string& channel)
+{
+    enable_event(lttng::EventRule{event}, channel);
+}
+
+void lttng::Session::enable_event(const lttng::EventRule& rule, const std::string& channel)
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"start", name_},
-                copy_env(), core::posix::StandardStream::empty);
+    backend_->enable_event(name_, domain_, channel, rule);
+}
 
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+void lttng::Session::start()
+{
+    backend_->start(name_);
 }
 
 void lttng::Session::stop()
 {
-    auto cp = core::posix::exec(
-                "/usr/bin/lttng", {"stop", name_},
-                copy_env(), core::posix::StandardStream::stdout);
+    backend_->stop(name_);
+}
+
+boost::filesystem::path lttng::Session::record_snapshot()
+{
+    auto consumer = std::dynamic_pointer_cast<lttng::FileSystemConsumer>(consumer_);
+    if (not consumer)
+        throw std::runtime_error("Session::record_snapshot: the consumer of the session does not record to the file system");
+
+    return record_snapshot(consumer);
+}
+
+boost::filesystem::path lttng::Session::record_snapshot(const std::shared_ptr<lttng::FileSystemConsumer>& consumer)
+{
+    if (mode_ != lttng::SessionMode::snapshot)
+        throw std::runtime_error("Session::record_snapshot: not a snapshot session");
+
+    // lttng appends the time and a sequence number to the snapshot name, we thus
+    // identify the snapshot directory as the one that did not exist before.
+    auto before = subdirectories(consumer->path());
+    backend_->record_snapshot(name_, name_ + "-snapshot-" + boost::lexical_cast<std::string>(snapshots_++), consumer->to_url());
+
+    for (const auto& directory : subdirectories(consumer->path()))
+        if (before.count(directory) == 0)
+            return directory;
+
+    throw std::runtime_error("Session::record_snapshot: no snapshot has been written to " + consumer->path().string());
+}
+
+boost::filesystem::path lttng::Session::rotate()
+{
+    if (mode_ != lttng::SessionMode::regular)
+        throw std::runtime_error("Session::rotate: not a regular session");
+
+    auto consumer = std::dynamic_pointer_cast<lttng::FileSystemConsumer>(consumer_);
+    if (not consumer)
+        throw std::runtime_error("Session::rotate: the consumer of the session does not record to the file system");
+
+    // Keep the chunk watcher from removing the new chunk, it is handed to the caller.
+    std::unique_lock<std::mutex> hold;
+    if (chunk_watcher_)
+        hold = chunk_watcher_->hold();
+
+    // lttng names chunks after their begin and end time, we thus identify the
+    // new chunk as the one that did not exist before.
+    auto archives = consumer->path() / "archives";
+    auto before = boost::filesystem::exists(archives) ? subdirectories(archives) : std::set<boost::filesystem::path>{};
+    backend_->rotate(name_);
 
-    throw_if_error(cp.wait_for(core::posix::wait::Flags::untraced));
+    if (boost::filesystem::exists(archives))
+    {
+        for (const auto& directory : subdirectories(archives))
+        {
+            if (before.count(directory) == 0)
+            {
+                if (chunk_watcher_)
+                    chunk_watcher_->keep(directory);
+                return directory;
+            }
+        }
+    }
+
+    throw std::runtime_error("Session::rotate: no chunk has been archived to " + archives.string());
+}
+
+void lttng::Session::enable_rotation(const lttng::RotationSchedule& schedule)
+{
+    if (not schedule.period && not schedule.size)
+        throw std::runtime_error("Session::enable_rotation: schedule sets neither period nor size");
+
+    disable_rotation();
+    backend_->enable_rotation(name_, schedule);
+    rotation_ = schedule;
+}
+
+void lttng::Session::disable_rotation()
+{
+    if (not rotation_)
+        return;
+
+    backend_->disable_rotation(name_, *rotation_);
+    rotation_ = boost::none;
+}
+
+void lttng::Session::on_chunk(const lttng::Session::ChunkHandler& handler, bool remove_handled, std::chrono::milliseconds poll_interval)
+{
+    auto consumer = std::dynamic_pointer_cast<lttng::FileSystemConsumer>(consumer_);
+    if (not consumer)
+        throw std::runtime_error("Session::on_chunk: the consumer of the session does not record to the file system");
+
+    chunk_watcher_.reset();
+    chunk_watcher_.reset(new ChunkWatcher{consumer->path() / "archives", handler, remove_handled, poll_interval});
+}
+
+std::future<void> lttng::Session::async_start()
+{
+    auto backend = backend_; auto name = name_;
+    return std::async(std::launch::async, [backend, name]() { backend->start(name); });
+}
+
+void lttng::Session::async_start(boost::asio::io_service& io_service, const lttng::Session::CompletionHandler& handler)
+{
+    auto backend = backend_; auto name = name_;
+    run_and_post(io_service, [backend, name]() { backend->start(name); }, handler);
+}
+
+std::future<void> lttng::Session::async_stop()
+{
+    auto backend = backend_; auto name = name_;
+    return std::async(std::launch::async, [backend, name]() { backend->stop(name); });
+}
+
+void lttng::Session::async_stop(boost::asio::io_service& io_service, const lttng::Session::CompletionHandler& handler)
+{
+    auto backend = backend_; auto name = name_;
+    run_and_post(io_service, [backend, name]() { backend->stop(name); }, handler);
 }
@@ -0,0 +1,426 @@
+#include <lttng/lttng.h>
+
+// The umbrella header of liblttng-ctl is shadowed by include/lttng/lttng.h,
+// we thus include the individual headers instead.
+#include <lttng/channel.h>
+#include <lttng/domain.h>
+#include <lttng/event.h>
+#include <lttng/handle.h>
+#include <lttng/load.h>
+#include <lttng/lttng-error.h>
+#if defined(LTTNG_HAVE_LTTNG_CTL_ROTATION)
+#include <lttng/rotation.h>
+#endif
+#include <lttng/session.h>
+#include <lttng/snapshot.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// liblttng-ctl keeps its connection to the session daemon in global state, we thus serialize all calls.
+// Commands that wait for the session daemon, like stop and rotate, only hold the guard while polling.
+std::mutex& library_guard()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+void throw_if_error(int rc)
+{
+    if (rc < 0)
+        throw lttng::Exception(rc);
+}
+
+lttng_domain domain_for(lttng::Domain domain)
+{
+    lttng_domain result;
+    std::memset(&result, 0, sizeof(result));
+
+    switch (domain)
+    {
+    case lttng::Domain::kernel:
+        result.type = LTTNG_DOMAIN_KERNEL;
+        result.buf_type = LTTNG_BUFFER_GLOBAL;
+        break;
+    case lttng::Domain::userspace:
+        result.type = LTTNG_DOMAIN_UST;
+        result.buf_type = LTTNG_BUFFER_PER_UID;
+        break;
+    }
+
+    return result;
+}
+
+lttng_domain domain_for(lttng::Domain domain, lttng::Channel::Buffers buffers)
+{
+    auto result = domain_for(domain);
+
+    switch (buffers)
+    {
+    case lttng::Channel::Buffers::per_uid: result.buf_type = LTTNG_BUFFER_PER_UID; break;
+    case lttng::Channel::Buffers::per_pid: result.buf_type = LTTNG_BUFFER_PER_PID; break;
+    case lttng::Channel::Buffers::global: result.buf_type = LTTNG_BUFFER_GLOBAL; break;
+    }
+
+    return result;
+}
+
+#if defined(LTTNG_HAVE_LTTNG_CTL_ROTATION)
+void throw_if_rotation_error(lttng_rotation_status status)
+{
+    if (status != LTTNG_ROTATION_STATUS_OK)
+        throw std::runtime_error("liblttng-ctl: rotation failed with status " + std::to_string(static_cast<int>(status)));
+}
+#else
+[[noreturn]] void throw_rotation_unsupported()
+{
+    throw std::runtime_error("liblttng-ctl: session rotation requires liblttng-ctl 2.11 or later, use ControlBackend::exec() instead");
+}
+#endif
+
+// Copies the given name to a fixed-size buffer of liblttng-ctl, throwing if it does not fit.
+template<std::size_t size>
+void copy_name(const std::string& name, char (&buffer)[size])
+{
+    if (name.size() >= size)
+        throw lttng::Exception(-LTTNG_ERR_INVALID);
+
+    std::strncpy(buffer, name.c_str(), size - 1);
+}
+
+// Returns a c string for the given channel name, nullptr for the default channel.
+const char* channel_or_default(const std::string& channel)
+{
+    return channel.empty() ? nullptr : channel.c_str();
+}
+
+lttng_event_context_type context_type_for(lttng::Context context)
+{
+    switch (context)
+    {
+    case lttng::Context::pid: return LTTNG_EVENT_CONTEXT_PID;
+    case lttng::Context::proc_name: return LTTNG_EVENT_CONTEXT_PROCNAME;
+    case lttng::Context::prio: return LTTNG_EVENT_CONTEXT_PRIO;
+    case lttng::Context::nice: return LTTNG_EVENT_CONTEXT_NICE;
+    case lttng::Context::vpid: return LTTNG_EVENT_CONTEXT_VPID;
+    case lttng::Context::tid: return LTTNG_EVENT_CONTEXT_TID;
+    case lttng::Context::vtid: return LTTNG_EVENT_CONTEXT_VTID;
+    case lttng::Context::ppid: return LTTNG_EVENT_CONTEXT_PPID;
+    case lttng::Context::vppid: return LTTNG_EVENT_CONTEXT_VPPID;
+    case lttng::Context::pthread_id: return LTTNG_EVENT_CONTEXT_PTHREAD_ID;
+    case lttng::Context::hostname: return LTTNG_EVENT_CONTEXT_HOSTNAME;
+    case lttng::Context::ip: return LTTNG_EVENT_CONTEXT_IP;
+    }
+
+    throw lttng::Exception(-LTTNG_ERR_INVALID);
+}
+
+// Handle wraps an lttng_handle, destroying it when going out of scope.
+typedef std::unique_ptr<lttng_handle, void(*)(lttng_handle*)> Handle;
+
+Handle handle_for(const std::string& session, lttng_domain domain)
+{
+    Handle handle{lttng_create_handle(session.c_str(), &domain), lttng_destroy_handle};
+
+    if (not handle)
+        throw lttng::Exception(-LTTNG_ERR_UNK);
+
+    return handle;
+}
+
+Handle handle_for(const std::string& session, lttng::Domain domain)
+{
+    return handle_for(session, domain_for(domain));
+}
+
+#if defined(LTTNG_HAVE_LTTNG_CTL_ROTATION)
+// Schedule wraps an lttng_rotation_schedule, destroying it when going out of scope.
+typedef std::unique_ptr<lttng_rotation_schedule, void(*)(lttng_rotation_schedule*)> Schedule;
+
+// Returns one liblttng-ctl schedule per condition set in the given schedule.
+std::vector<Schedule> schedules_for(const lttng::RotationSchedule& schedule)
+{
+    std::vector<Schedule> result;
+
+    if (schedule.period)
+    {
+        Schedule periodic{lttng_rotation_schedule_periodic_create(), lttng_rotation_schedule_destroy};
+        if (not periodic)
+            throw lttng::Exception(-LTTNG_ERR_NOMEM);
+
+        throw_if_rotation_error(lttng_rotation_schedule_periodic_set_period(periodic.get(), schedule.period->count()));
+        result.push_back(std::move(periodic));
+    }
+
+    if (schedule.size)
+    {
+        Schedule threshold{lttng_rotation_schedule_size_threshold_create(), lttng_rotation_schedule_destroy};
+        if (not threshold)
+            throw lttng::Exception(-LTTNG_ERR_NOMEM);
+
+        throw_if_rotation_error(lttng_rotation_schedule_size_threshold_set_threshold(threshold.get(), *schedule.size));
+        result.push_back(std::move(threshold));
+    }
+
+    return result;
+}
+#endif
+
+// LttngCtlControlBackend talks to the session daemon through liblttng-ctl, in-process.
+class LttngCtlControlBackend : public lttng::ControlBackend
+{
+protected:
+    void do_create_session(const std::string& name, const std::string& url) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        throw_if_error(lttng_create_session(name.c_str(), url.c_str()));
+    }
+
+    void do_create_snapshot_session(const std::string& name, const std::string& url) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        throw_if_error(lttng_create_session_snapshot(name.c_str(), url.c_str()));
+    }
+
+    void do_destroy_session(const std::string& name) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        throw_if_error(lttng_destroy_session(name.c_str()));
+    }
+
+    void do_enable_channel(const std::string& session, lttng::Domain domain, const lttng::Channel& channel) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        auto d = domain_for(domain, channel.buffers);
+
+        // lttng_channel_create fills in the defaults of the domain, including the extended attributes.
+        std::unique_ptr<lttng_channel, void(*)(lttng_channel*)> chan{lttng_channel_create(&d), lttng_channel_destroy};
+        if (not chan)
+            throw lttng::Exception(-LTTNG_ERR_NOMEM);
+
+        copy_name(channel.name, chan->name);
+        chan->enabled = 1;
+        chan->attr.overwrite = channel.mode == lttng::Channel::Mode::overwrite ? 1 : 0;
+        chan->attr.subbuf_size = channel.subbuffer_size;
+        chan->attr.num_subbuf = channel.subbuffer_count;
+        chan->attr.switch_timer_interval = channel.switch_timer.count();
+        chan->attr.read_timer_interval = channel.read_timer.count();
+        chan->attr.output = channel.output == lttng::Channel::Output::mmap ? LTTNG_EVENT_MMAP : LTTNG_EVENT_SPLICE;
+        chan->attr.tracefile_size = channel.tracefile_size;
+        chan->attr.tracefile_count = channel.tracefile_count;
+
+        if (channel.monitor_timer)
+            throw_if_error(lttng_channel_set_monitor_timer_interval(chan.get(), channel.monitor_timer->count()));
+
+        auto handle = handle_for(session, d);
+        throw_if_error(lttng_enable_channel(handle.get(), chan.get()));
+    }
+
+    void do_add_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::Context context) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        lttng_event_context ctx;
+        std::memset(&ctx, 0, sizeof(ctx));
+        ctx.ctx = context_type_for(context);
+
+        auto handle = handle_for(session, domain);
+        throw_if_error(lttng_add_context(handle.get(), &ctx, nullptr, channel_or_default(channel)));
+    }
+
+    void do_add_perf_context(const std::string& session, lttng::Domain domain, const std::string& channel, lttng::PerfCounter counter) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        lttng_event_context ctx;
+        std::memset(&ctx, 0, sizeof(ctx));
+
+        // The kernel tracer samples counters per cpu, the userspace tracer per thread.
+        ctx.ctx = domain == lttng::Domain::kernel ? LTTNG_EVENT_CONTEXT_PERF_CPU_COUNTER : LTTNG_EVENT_CONTEXT_PERF_THREAD_COUNTER;
+
+        auto config = lttng::perf_event_config(counter);
+        ctx.u.perf_counter.type = config.type;
+        ctx.u.perf_counter.config = config.config;
+        copy_name(lttng::perf_field_name(domain, counter), ctx.u.perf_counter.name);
+
+        auto handle = handle_for(session, domain);
+        throw_if_error(lttng_add_context(handle.get(), &ctx, nullptr, channel_or_default(channel)));
+    }
+
+    void do_enable_event(const std::string& session, lttng::Domain domain, const std::string& channel, const lttng::EventRule& rule) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        lttng_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.type = LTTNG_EVENT_TRACEPOINT;
+        copy_name(rule.name, ev.name);
+
+        switch (rule.log_level_match)
+        {
+        case lttng::EventRule::LogLevelMatch::all:
+            ev.loglevel_type = LTTNG_EVENT_LOGLEVEL_ALL;
+            ev.loglevel = -1;
+            break;
+        case lttng::EventRule::LogLevelMatch::range:
+            ev.loglevel_type = LTTNG_EVENT_LOGLEVEL_RANGE;
+            ev.loglevel = static_cast<int>(rule.log_level);
+            break;
+        case lttng::EventRule::LogLevelMatch::single:
+            ev.loglevel_type = LTTNG_EVENT_LOGLEVEL_SINGLE;
+            ev.loglevel = static_cast<int>(rule.log_level);
+            break;
+        }
+
+        // liblttng-ctl takes exclusions as non-const strings, without modifying them.
+        std::vector<char*> exclusions;
+        for (const auto& exclusion : rule.exclusions)
+        {
+            if (exclusion.size() >= LTTNG_SYMBOL_NAME_LEN)
+                throw lttng::Exception(-LTTNG_ERR_INVALID);
+
+            exclusions.push_back(const_cast<char*>(exclusion.c_str()));
+        }
+
+        auto handle = handle_for(session, domain);
+        throw_if_error(lttng_enable_event_with_exclusions(
+                           handle.get(), &ev, channel_or_default(channel),
+                           rule.filter.empty() ? nullptr : rule.filter.c_str(),
+                           exclusions.size(), exclusions.empty() ? nullptr : exclusions.data()));
+    }
+
+    void do_start(const std::string& session) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        throw_if_error(lttng_start_tracing(session.c_str()));
+    }
+
+    void do_stop(const std::string& session) override
+    {
+        {
+            std::lock_guard<std::mutex> lg{library_guard()};
+            throw_if_error(lttng_stop_tracing_no_wait(session.c_str()));
+        }
+
+        // Consumers flush their buffers asynchronously, we poll without holding the library guard to not stall other commands.
+        for (;;)
+        {
+            int pending{0};
+            {
+                std::lock_guard<std::mutex> lg{library_guard()};
+                pending = lttng_data_pending(session.c_str());
+            }
+
+            throw_if_error(pending);
+
+            if (pending == 0)
+                return;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+    }
+
+    void do_record_snapshot(const std::string& session, const std::string& snapshot, const std::string& url) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        std::unique_ptr<lttng_snapshot_output, void(*)(lttng_snapshot_output*)> output
+        {
+            lttng_snapshot_output_create(), lttng_snapshot_output_destroy
+        };
+
+        if (not output)
+            throw lttng::Exception(-LTTNG_ERR_NOMEM);
+
+        throw_if_error(lttng_snapshot_output_set_name(snapshot.c_str(), output.get()));
+        throw_if_error(lttng_snapshot_output_set_ctrl_url(url.c_str(), output.get()));
+        throw_if_error(lttng_snapshot_record(session.c_str(), output.get(), 0));
+    }
+
+    void do_load_session(const std::string& name, const boost::filesystem::path& file) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        std::unique_ptr<lttng_load_session_attr, void(*)(lttng_load_session_attr*)> attr
+        {
+            lttng_load_session_attr_create(), lttng_load_session_attr_destroy
+        };
+
+        if (not attr)
+            throw lttng::Exception(-LTTNG_ERR_NOMEM);
+
+        throw_if_error(lttng_load_session_attr_set_session_name(attr.get(), name.c_str()));
+        throw_if_error(lttng_load_session_attr_set_input_url(attr.get(), boost::filesystem::absolute(file).c_str()));
+        throw_if_error(lttng_load_session(attr.get()));
+    }
+
+#if defined(LTTNG_HAVE_LTTNG_CTL_ROTATION)
+    void do_rotate(const std::string& session) override
+    {
+        lttng_rotation_handle* h{nullptr};
+        {
+            std::lock_guard<std::mutex> lg{library_guard()};
+            throw_if_error(lttng_rotate_session(session.c_str(), nullptr, &h));
+        }
+
+        std::unique_ptr<lttng_rotation_handle, void(*)(lttng_rotation_handle*)> handle{h, lttng_rotation_handle_destroy};
+
+        // Rotations complete asynchronously, we poll without holding the library guard to not stall other commands.
+        for (;;)
+        {
+            lttng_rotation_state state;
+            {
+                std::lock_guard<std::mutex> lg{library_guard()};
+                throw_if_rotation_error(lttng_rotation_handle_get_state(handle.get(), &state));
+            }
+
+            switch (state)
+            {
+            case LTTNG_ROTATION_STATE_ONGOING:
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+                break;
+            case LTTNG_ROTATION_STATE_COMPLETED:
+                return;
+            default:
+                throw std::runtime_error("liblttng-ctl: rotation of " + session + " did not complete");
+            }
+        }
+    }
+
+    void do_enable_rotation(const std::string& session, const lttng::RotationSchedule& schedule) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        for (const auto& s : schedules_for(schedule))
+            throw_if_rotation_error(lttng_session_add_rotation_schedule(session.c_str(), s.get()));
+    }
+
+    void do_disable_rotation(const std::string& session, const lttng::RotationSchedule& schedule) override
+    {
+        std::lock_guard<std::mutex> lg{library_guard()};
+        for (const auto& s : schedules_for(schedule))
+            throw_if_rotation_error(lttng_session_remove_rotation_schedule(session.c_str(), s.get()));
+    }
+#else
+    void do_rotate(const std::string&) override
+    {
+        throw_rotation_unsupported();
+    }
+
+    void do_enable_rotation(const std::string&, const lttng::RotationSchedule&) override
+    {
+        throw_rotation_unsupported();
+    }
+
+    void do_disable_rotation(const std::string&, const lttng::RotationSchedule&) override
+    {
+        throw_rotation_unsupported();
+    }
+#endif
+};
+}
+
+std::shared_ptr<lttng::ControlBackend> lttng::ControlBackend::lttng_ctl()
+{
+    return std::make_shared<LttngCtlControlBackend>();
+}
@@ -0,0 +1,352 @@
+#include <lttng/lttng.h>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <sstream>
+
+namespace
+{
+constexpr const char* file_scheme{"file://"};
+
+// UrlConsumer hands out a url that is not backed by a local directory, e.g., for network streaming.
+class UrlConsumer : public lttng::Consumer
+{
+public:
+    explicit UrlConsumer(const std::string& url) : url(url)
+    {
+    }
+
+    std::string to_url() const override
+    {
+        return url;
+    }
+
+private:
+    std::string url;
+};
+
+// Contexts known to session descriptions, in the order of lttng::Context.
+const lttng::Context all_contexts[] =
+{
+    lttng::Context::pid, lttng::Context::proc_name, lttng::Context::prio, lttng::Context::nice,
+    lttng::Context::vpid, lttng::Context::tid, lttng::Context::vtid, lttng::Context::ppid,
+    lttng::Context::vppid, lttng::Context::pthread_id, lttng::Context::hostname, lttng::Context::ip
+};
+
+const lttng::PerfCounter all_perf_counters[] =
+{
+    lttng::PerfCounter::cpu_cycles, lttng::PerfCounter::instructions, lttng::PerfCounter::cache_references,
+    lttng::PerfCounter::cache_misses, lttng::PerfCounter::branch_instructions, lttng::PerfCounter::branch_misses,
+    lttng::PerfCounter::bus_cycles, lttng::PerfCounter::stalled_cycles_frontend, lttng::PerfCounter::stalled_cycles_backend,
+    lttng::PerfCounter::cpu_clock, lttng::PerfCounter::task_clock, lttng::PerfCounter::page_faults,
+    lttng::PerfCounter::context_switches, lttng::PerfCounter::cpu_migrations, lttng::PerfCounter::minor_faults,
+    lttng::PerfCounter::major_faults
+};
+
+const lttng::Channel::Mode all_modes[] = {lttng::Channel::Mode::discard, lttng::Channel::Mode::overwrite};
+const lttng::Channel::Buffers all_buffers[] = {lttng::Channel::Buffers::per_uid, lttng::Channel::Buffers::per_pid, lttng::Channel::Buffers::global};
+const lttng::Channel::Output all_outputs[] = {lttng::Channel::Output::mmap, lttng::Channel::Output::splice};
+const lttng::EventRule::LogLevelMatch all_log_level_matches[] =
+{
+    lttng::EventRule::LogLevelMatch::all, lttng::EventRule::LogLevelMatch::range, lttng::EventRule::LogLevelMatch::single
+};
+
+// Session descriptions spell enumerators in upper case, e.g., PROCNAME or PER_UID.
+template<typename T>
+std::string xml_name(T value)
+{
+    return boost::algorithm::to_upper_copy(boost::lexical_cast<std::string>(value));
+}
+
+template<typename T, std::size_t size>
+T from_xml_name(const T (&candidates)[size], const std::string& value)
+{
+    for (auto candidate : candidates)
+        if (xml_name(candidate) == value)
+            return candidate;
+
+    throw std::runtime_error("SessionConfig: unsupported value " + value);
+}
+
+// Session descriptions identify perf counters by their perf_event_open(2) configuration.
+lttng::PerfCounter perf_counter_from_xml(const boost::property_tree::ptree& perf)
+{
+    auto type = perf.get<std::uint32_t>("type");
+    auto config = perf.get<std::uint64_t>("config");
+
+    for (auto candidate : all_perf_counters)
+        if (lttng::perf_event_config(candidate).type == type && lttng::perf_event_config(candidate).config == config)
+            return candidate;
+
+    throw std::runtime_error("SessionConfig: unsupported perf counter " + perf.get("name", std::string{}));
+}
+
+void add_channel(boost::property_tree::ptree& channels, lttng::Domain domain, const lttng::SessionConfig::ChannelConfig& config)
+{
+    const auto& channel = config.channel;
+    auto& c = channels.add("channel", "");
+
+    c.put("name", channel.name);
+    c.put("enabled", "true");
+    c.put("overwrite_mode", xml_name(channel.mode));
+    c.put("subbuffer_size", channel.subbuffer_size);
+    c.put("subbuffer_count", channel.subbuffer_count);
+    c.put("switch_timer_interval", channel.switch_timer.count());
+    c.put("read_timer_interval", channel.read_timer.count());
+    c.put("output_type", xml_name(channel.output));
+    c.put("tracefile_size", channel.tracefile_size);
+    c.put("tracefile_count", channel.tracefile_count);
+    c.put("live_timer_interval", 0);
+
+    for (const auto& event : config.events)
+    {
+        auto& e = c.add("events.event", "");
+        e.put("name", event.name);
+        e.put("enabled", "true");
+        e.put("type", "TRACEPOINT");
+        e.put("loglevel_type", xml_name(event.log_level_match));
+        e.put("loglevel", event.log_level_match == lttng::EventRule::LogLevelMatch::all ? -1 : static_cast<int>(event.log_level));
+
+        if (not event.filter.empty())
+            e.put("filter", event.filter);
+
+        for (const auto& exclusion : event.exclusions)
+            e.add("exclusions.exclusion", exclusion);
+    }
+
+    for (auto context : config.contexts)
+        c.add("contexts.context", "").put("type", xml_name(context));
+
+    for (auto counter : config.perf_counters)
+    {
+        auto& perf = c.add("contexts.context", "").add("perf", "");
+        perf.put("type", lttng::perf_event_config(counter).type);
+        perf.put("config", lttng::perf_event_config(counter).config);
+        perf.put("name", lttng::perf_field_name(domain, counter));
+    }
+
+    if (channel.monitor_timer)
+        c.put("monitor_timer_interval", channel.monitor_timer->count());
+}
+
+lttng::EventRule rule_from_xml(const boost::property_tree::ptree& e)
+{
+    lttng::EventRule rule{e.get<std::string>("name")};
+
+    rule.filter = e.get("filter", rule.filter);
+    rule.log_level_match = from_xml_name(all_log_level_matches, e.get("loglevel_type", xml_name(rule.log_level_match)));
+
+    if (rule.log_level_match != lttng::EventRule::LogLevelMatch::all)
+        rule.log_level = static_cast<lttng::LogLevel>(e.get<int>("loglevel"));
+
+    if (auto exclusions = e.get_child_optional("exclusions"))
+        for (const auto& exclusion : *exclusions)
+            rule.exclusions.push_back(exclusion.second.data());
+
+    return rule;
+}
+
+lttng::Channel channel_from_xml(lttng::Domain domain, const boost::property_tree::ptree& c, lttng::Channel::Buffers buffers)
+{
+    auto channel = lttng::Channel::defaults(domain, c.get<std::string>("name"));
+
+    channel.subbuffer_size = c.get("subbuffer_size", channel.subbuffer_size);
+    channel.subbuffer_count = c.get("subbuffer_count", channel.subbuffer_count);
+    channel.mode = from_xml_name(all_modes, c.get("overwrite_mode", xml_name(channel.mode)));
+    channel.buffers = buffers;
+    channel.output = from_xml_name(all_outputs, c.get("output_type", xml_name(channel.output)));
+    channel.switch_timer = std::chrono::microseconds{c.get("switch_timer_interval", channel.switch_timer.count())};
+    channel.read_timer = std::chrono::microseconds{c.get("read_timer_interval", channel.read_timer.count())};
+    channel.tracefile_size = c.get("tracefile_size", channel.tracefile_size);
+    channel.tracefile_count = c.get("tracefile_count", channel.tracefile_count);
+
+    if (auto monitor_timer = c.get_optional<std::chrono::microseconds::rep>("monitor_timer_interval"))
+        channel.monitor_timer = std::chrono::microseconds{*monitor_timer};
+
+    return channel;
+}
+}
+
+constexpr const char* lttng::SessionConfig::default_channel;
+
+lttng::SessionConfig lttng::SessionConfig::load(const boost::filesystem::path& path)
+{
+    boost::filesystem::ifstream in{path};
+    if (not in)
+        throw std::runtime_error("SessionConfig::load: could not open " + path.string());
+
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_xml(in, tree, boost::property_tree::xml_parser::trim_whitespace);
+
+    const auto& session = tree.get_child("sessions.session");
+    const auto& domain = session.get_child("domains.domain");
+    const auto& destination = session.get_child("output.consumer_output.destination");
+
+    auto type = domain.get<std::string>("type");
+    if (type != "KERNEL" && type != "UST")
+        throw std::runtime_error("SessionConfig::load: unsupported domain " + type);
+
+    std::shared_ptr<lttng::Consumer> consumer;
+    if (auto local = destination.get_optional<std::string>("path"))
+        consumer = std::make_shared<lttng::FileSystemConsumer>(*local);
+    else
+        consumer = std::make_shared<UrlConsumer>(destination.get<std::string>("net_output.control_uri"));
+
+    lttng::SessionConfig config
+    {
+        type == "KERNEL" ? lttng::Domain::kernel : lttng::Domain::userspace,
+        session.get<std::string>("name"),
+        consumer
+    };
+
+    auto buffers = from_xml_name(all_buffers, domain.get<std::string>("buffer_type"));
+
+    for (const auto& channel : domain.get_child("channels"))
+    {
+        config.channel(channel_from_xml(config.domain(), channel.second, buffers));
+
+        if (auto contexts = channel.second.get_child_optional("contexts"))
+        {
+            for (const auto& context : *contexts)
+            {
+                if (auto perf = context.second.get_child_optional("perf"))
+                    config.add_context(perf_counter_from_xml(*perf));
+                else
+                    config.add_context(from_xml_name(all_contexts, context.second.get<std::string>("type")));
+            }
+        }
+
+        if (auto events = channel.second.get_child_optional("events"))
+            for (const auto& event : *events)
+                config.enable_event(rule_from_xml(event.second));
+    }
+
+    return config;
+}
+
+lttng::SessionConfig::SessionConfig(lttng::Domain domain, const std::string& name, const std::shared_ptr<lttng::Consumer>& consumer)
+    : domain_(domain),
+      name_(name),
+      consumer_(consumer),
+      current_(0)
+{
+}
+
+lttng::SessionConfig& lttng::SessionConfig::channel(const std::string& name)
+{
+    for (current_ = 0; current_ < channels_.size(); current_++)
+        if (channels_[current_].channel.name == name)
+            return *this;
+
+    channels_.push_back(lttng::SessionConfig::ChannelConfig{lttng::Channel::defaults(domain_, name), {}, {}, {}});
+    return *this;
+}
+
+lttng::SessionConfig& lttng::SessionConfig::channel(const lttng::Channel& channel)
+{
+    this->channel(channel.name);
+    channels_[current_].channel = channel;
+    return *this;
+}
+
+lttng::SessionConfig& lttng::SessionConfig::add_context(lttng::Context context)
+{
+    current().contexts.push_back(context);
+    return *this;
+}
+
+lttng::SessionConfig& lttng::SessionConfig::add_context(lttng::PerfCounter counter)
+{
+    current().perf_counters.push_back(counter);
+    return *this;
+}
+
+lttng::SessionConfig& lttng::SessionConfig::enable_event(const std::string& event, const std::string& filter)
+{
+    lttng::EventRule rule{event};
+    rule.filter = filter;
+
+    return enable_event(rule);
+}
+
+lttng::SessionConfig& lttng::SessionConfig::enable_event(const lttng::EventRule& rule)
+{
+    current().events.push_back(rule);
+    return *this;
+}
+
+lttng::Domain lttng::SessionConfig::domain() const
+{
+    return domain_;
+}
+
+const std::string& lttng::SessionConfig::name() const
+{
+    return name_;
+}
+
+const std::shared_ptr<lttng::Consumer>& lttng::SessionConfig::consumer() const
+{
+    return consumer_;
+}
+
+const std::vector<lttng::SessionConfig::ChannelConfig>& lttng::SessionConfig::channels() const
+{
+    return channels_;
+}
+
+std::string lttng::SessionConfig::to_xml() const
+{
+    boost::property_tree::ptree tree;
+
+    auto& session = tree.add("sessions.session", "");
+    session.put("name", name_);
+
+    auto& domain = session.add("domains.domain", "");
+    domain.put("type", domain_ == lttng::Domain::kernel ? "KERNEL" : "UST");
+    // Buffer ownership is fixed per domain, by the first channel.
+    domain.put("buffer_type", xml_name(channels_.empty() ? lttng::Channel::defaults(domain_, default_channel).buffers : channels_.front().channel.buffers));
+
+    auto& channels = domain.add("channels", "");
+    for (const auto& channel : channels_)
+        add_channel(channels, domain_, channel);
+
+    session.put("started", "false");
+
+    auto& output = session.add("output.consumer_output", "");
+    output.put("enabled", "true");
+
+    auto url = consumer_->to_url();
+    if (boost::algorithm::starts_with(url, file_scheme))
+        output.put("destination.path", url.substr(std::string{file_scheme}.size()));
+    else
+    {
+        output.put("destination.net_output.control_uri", url);
+        output.put("destination.net_output.data_uri", url);
+    }
+
+    std::stringstream ss; boost::property_tree::write_xml(ss, tree);
+    return ss.str();
+}
+
+void lttng::SessionConfig::save(const boost::filesystem::path& path) const
+{
+    boost::filesystem::ofstream out{path};
+    out << to_xml();
+
+    if (not out)
+        throw std::runtime_error("SessionConfig::save: could not write " + path.string());
+}
+
+lttng::SessionConfig::ChannelConfig& lttng::SessionConfig::current()
+{
+    if (channels_.empty())
+        channel(default_channel);
+
+    return channels_[current_];
+}
@@ -0,0 +1,269 @@
+#include <lttng/symbolizer.h>
+#include <lttng/lttng.h>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// Elf32 and Elf64 bundle the ELF types of the respective class.
+struct Elf32
+{
+  typedef Elf32_Ehdr Ehdr;
+  typedef Elf32_Phdr Phdr;
+  typedef Elf32_Shdr Shdr;
+  typedef Elf32_Sym Sym;
+};
+
+struct Elf64
+{
+  typedef Elf64_Ehdr Ehdr;
+  typedef Elf64_Phdr Phdr;
+  typedef Elf64_Shdr Shdr;
+  typedef Elf64_Sym Sym;
+};
+
+// Entry is a function or object symbol of an ELF file.
+struct Entry
+{
+  std::uint64_t address;
+  std::uint64_t size;
+  std::uint32_t name; // Offset into the string table.
+};
+
+// Copies a T from data at offset, returning false if it exceeds data.
+template<typename T>
+bool read_at(const std::vector<char>& data, std::uint64_t offset, T& t)
+{
+  if (offset > data.size() || data.size() - offset < sizeof(T))
+    return false;
+
+  std::memcpy(&t, data.data() + offset, sizeof(T));
+  return true;
+}
+}
+
+// Object models a loaded object, reading its symbol table on first use.
+class ctf::Symbolizer::Object
+{
+ public:
+  explicit Object(const boost::filesystem::path& path)
+      : path(path),
+        loaded(false),
+        first_load_address(0)
+  {
+  }
+
+  // Resolves the given offset relative to the base address the object is loaded at.
+  const ctf::Symbol* resolve(std::uint64_t offset)
+  {
+    if (not loaded)
+      load();
+
+    auto address = first_load_address + offset;
+    auto cached = cache.find(address);
+
+    if (cached != cache.end())
+      return cached->second.get();
+
+    std::unique_ptr<ctf::Symbol> symbol;
+
+    auto it = std::upper_bound(entries.begin(), entries.end(), address, [](std::uint64_t a, const Entry& e)
+    {
+      return a < e.address;
+    });
+
+    if (it != entries.begin())
+    {
+      --it;
+
+      if (it->size == 0 || address < it->address + it->size)
+        symbol.reset(new ctf::Symbol{std::string(strings.data() + it->name), address - it->address, path});
+    }
+
+    auto result = symbol.get();
+    cache[address] = std::move(symbol);
+    return result;
+  }
+
+ private:
+  // Reads the symbol table of the ELF file. Objects that cannot be read resolve nothing.
+  void load()
+  {
+    loaded = true;
+
+    boost::filesystem::ifstream in{path, std::ios::binary};
+    std::vector<char> data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    if (data.size() < EI_NIDENT || std::memcmp(data.data(), ELFMAG, SELFMAG) != 0)
+      return;
+
+    switch (data[EI_CLASS])
+    {
+      case ELFCLASS32:
+        load<Elf32>(data);
+        break;
+      case ELFCLASS64:
+        load<Elf64>(data);
+        break;
+      default:
+        break;
+    }
+  }
+
+  template<typename Elf>
+  void load(const std::vector<char>& data)
+  {
+    typename Elf::Ehdr ehdr;
+    if (not read_at(data, 0, ehdr))
+      return;
+
+    // Objects are loaded at the base address minus the page-aligned address of their first segment.
+    for (std::uint16_t i = 0; i < ehdr.e_phnum; i++)
+    {
+      typename Elf::Phdr phdr;
+      if (read_at(data, ehdr.e_phoff + i * std::uint64_t{ehdr.e_phentsize}, phdr) && phdr.p_type == PT_LOAD)
+      {
+        first_load_address = phdr.p_vaddr & ~(std::uint64_t{phdr.p_align ? phdr.p_align : 1} - 1);
+        break;
+      }
+    }
+
+    // Prefer the full symbol table, falling back to the dynamic one for stripped objects.
+    std::vector<typename Elf::Shdr> sections(ehdr.e_shnum);
+    for (std::uint16_t i = 0; i < ehdr.e_shnum; i++)
+      if (not read_at(data, ehdr.e_shoff + i * std::uint64_t{ehdr.e_shentsize}, sections[i]))
+        return;
+
+    const typename Elf::Shdr* symtab{nullptr};
+    for (const auto& section : sections)
+      if (section.sh_type == SHT_SYMTAB || (section.sh_type == SHT_DYNSYM && not symtab))
+        symtab = &section;
+
+    if (not symtab || symtab->sh_link >= sections.size() || symtab->sh_entsize == 0)
+      return;
+
+    const auto& strtab = sections[symtab->sh_link];
+    if (strtab.sh_offset > data.size() || data.size() - strtab.sh_offset < strtab.sh_size)
+      return;
+
+    strings.assign(data.data() + strtab.sh_offset, strtab.sh_size);
+
+    for (std::uint64_t offset = 0; offset + sizeof(typename Elf::Sym) <= symtab->sh_size; offset += symtab->sh_entsize)
+    {
+      typename Elf::Sym sym;
+      if (not read_at(data, symtab->sh_offset + offset, sym))
+        break;
+
+      auto type = ELF64_ST_TYPE(sym.st_info);
+      if ((type != STT_FUNC && type != STT_OBJECT) || sym.st_shndx == SHN_UNDEF || sym.st_name >= strings.size())
+        continue;
+
+      entries.push_back(Entry{sym.st_value, sym.st_size, sym.st_name});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs)
+    {
+      return lhs.address < rhs.address;
+    });
+  }
+
+  boost::filesystem::path path;
+  bool loaded;
+  std::uint64_t first_load_address;
+  std::string strings;
+  std::vector<Entry> entries;
+  std::unordered_map<std::uint64_t, std::unique_ptr<ctf::Symbol>> cache;
+};
+
+ctf::Symbolizer::Symbolizer(const boost::filesystem::path& sysroot)
+    : sysroot(sysroot)
+{
+}
+
+ctf::Symbolizer::~Symbolizer()
+{
+}
+
+void ctf::Symbolizer::add_object(std::int64_t vpid, std::uint64_t base, std::uint64_t size, const std::string& path)
+{
+  auto& object = objects[path];
+
+  if (not object)
+    object.reset(new Object{sysroot / boost::filesystem::path{path}.relative_path()});
+
+  auto end = base + size;
+  auto& mappings = processes[vpid];
+
+  // Remove all mappings overlapping [base, end).
+  auto it = mappings.lower_bound(base);
+  if (it != mappings.begin() && std::prev(it)->second.end > base)
+    --it;
+  while (it != mappings.end() && it->first < end)
+    it = mappings.erase(it);
+
+  mappings[base] = Mapping{end, object.get()};
+}
+
+bool ctf::Symbolizer::on_event(const ctf::Event& event)
+{
+  if (event.name != lttng::events::userspace::libc::soinfo)
+    return false;
+
+  auto vpid = event.fields.find(std::make_tuple(ctf::Scope::stream_event_context, std::string{"vpid"}));
+  auto baddr = event.fields.find(std::make_tuple(ctf::Scope::event_fields, std::string{"baddr"}));
+  auto memsz = event.fields.find(std::make_tuple(ctf::Scope::event_fields, std::string{"memsz"}));
+  auto sopath = event.fields.find(std::make_tuple(ctf::Scope::event_fields, std::string{"sopath"}));
+
+  if (vpid == event.fields.end() || baddr == event.fields.end() || memsz == event.fields.end() || sopath == event.fields.end())
+    return false;
+
+  add_object(
+      vpid->second.as_integer().as_int64(),
+      baddr->second.as_integer().as_uint64(),
+      memsz->second.as_integer().as_uint64(),
+      sopath->second.as_string());
+
+  return true;
+}
+
+const ctf::Symbol* ctf::Symbolizer::resolve(std::int64_t vpid, std::uint64_t address)
+{
+  auto process = processes.find(vpid);
+
+  if (process == processes.end())
+    return nullptr;
+
+  auto it = process->second.upper_bound(address);
+
+  if (it == process->second.begin())
+    return nullptr;
+
+  --it;
+
+  if (address >= it->second.end)
+    return nullptr;
+
+  return it->second.object->resolve(address - it->first);
+}
+
+const ctf::Symbol* ctf::Symbolizer::resolve(const ctf::Event& event)
+{
+  if (on_event(event))
+    return nullptr;
+
+  auto vpid = event.fields.find(std::make_tuple(ctf::Scope::stream_event_context, std::string{"vpid"}));
+  auto ip = event.fields.find(std::make_tuple(ctf::Scope::stream_event_context, std::string{"ip"}));
+
+  if (vpid == event.fields.end() || ip == event.fields.end())
+    return nullptr;
+
+  return resolve(vpid->second.as_integer().as_int64(), ip->second.as_integer().as_uint64());
+}
@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE catalog
+#include <boost/test/unit_test.hpp>
+
+#include "generated_trace.h"
+
+#include <lttng/catalog.h>
+
+#include <boost/filesystem/fstream.hpp>
+
+namespace
+{
+// Catalog is a root directory holding two generated traces at different depths,
+// a trace with broken metadata and a directory without any trace.
+struct Catalog
+{
+  Catalog()
+      : root(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-test-%%%%-%%%%"))
+  {
+    ctf::generator::generate(root / "a", ctf::generator::Shape{1000, 0, 2, 4096, 2, 1000000, 42, ctf::generator::Mix::libc}, 1);
+    ctf::generator::generate(root / "b" / "nested", ctf::generator::Shape{500, 0, 1, 4096, 2, 1000000, 42, ctf::generator::Mix::pthread}, 1);
+
+    boost::filesystem::create_directories(root / "c");
+    boost::filesystem::ofstream{root / "c" / "metadata"} << "not a trace";
+
+    boost::filesystem::create_directories(root / "empty");
+  }
+
+  ~Catalog()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(root, ec);
+  }
+
+  boost::filesystem::path root;
+};
+
+std::uint64_t count(ctf::Trace& trace, const ctf::TraceCatalog::Entry&)
+{
+  std::uint64_t result{0};
+
+  trace.for_each_event([&result](const ctf::Event&)
+  {
+    result++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ctf::Ordering::none);
+
+  return result;
+}
+}
+
+BOOST_AUTO_TEST_CASE(all_traces_below_the_root_are_described)
+{
+  Catalog fixture;
+  ctf::TraceCatalog catalog{fixture.root, 2};
+
+  const auto& entries = catalog.entries();
+  BOOST_REQUIRE_EQUAL(3u, entries.size());
+
+  BOOST_CHECK(fixture.root / "a" == entries[0].path);
+  BOOST_CHECK(not entries[0].error);
+  BOOST_REQUIRE_EQUAL(2u, entries[0].streams.size());
+  BOOST_CHECK(fixture.root / "a" / "channel0_0" == entries[0].streams[0]);
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(entries[0].streams[0]) + boost::filesystem::file_size(entries[0].streams[1]), entries[0].bytes);
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(fixture.root / "a" / "metadata"), entries[0].metadata_size);
+
+  BOOST_CHECK(fixture.root / "b" / "nested" == entries[1].path);
+  BOOST_CHECK_EQUAL(1u, entries[1].streams.size());
+
+  // The metadata of c is only interpreted when running an analysis.
+  BOOST_CHECK(fixture.root / "c" == entries[2].path);
+  BOOST_CHECK(entries[2].streams.empty());
+}
+
+BOOST_AUTO_TEST_CASE(failures_are_reported_per_trace)
+{
+  Catalog fixture;
+  ctf::TraceCatalog catalog{fixture.root};
+
+  auto outcomes = catalog.run<std::uint64_t>(count);
+  BOOST_REQUIRE_EQUAL(3u, outcomes.size());
+
+  BOOST_CHECK(outcomes[0].succeeded());
+  BOOST_CHECK_EQUAL(1000u, outcomes[0].get());
+
+  BOOST_CHECK(outcomes[1].succeeded());
+  BOOST_CHECK_EQUAL(500u, outcomes[1].get());
+
+  BOOST_CHECK(fixture.root / "c" == outcomes[2].path);
+  BOOST_CHECK(not outcomes[2].succeeded());
+  BOOST_CHECK(not outcomes[2].result);
+  BOOST_CHECK_THROW(outcomes[2].get(), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(rescanning_picks_up_new_traces)
+{
+  Catalog fixture;
+  ctf::TraceCatalog catalog{fixture.root};
+  BOOST_CHECK_EQUAL(3u, catalog.entries().size());
+
+  ctf::generator::generate(fixture.root / "empty", ctf::generator::Shape{100, 0, 1, 4096, 1, 1000000, 42, ctf::generator::Mix::libc}, 1);
+  catalog.rescan();
+
+  BOOST_REQUIRE_EQUAL(4u, catalog.entries().size());
+  BOOST_CHECK(fixture.root / "empty" == catalog.entries()[3].path);
+}
+
+BOOST_AUTO_TEST_CASE(a_missing_root_throws)
+{
+  BOOST_CHECK_THROW(ctf::TraceCatalog{boost::filesystem::path{"/does/not/exist"}}, boost::filesystem::filesystem_error);
+}
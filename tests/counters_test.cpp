@@ -0,0 +1,107 @@
+#define BOOST_TEST_MODULE counters
+#include <boost/test/unit_test.hpp>
+
+#include <lttng/counters.h>
+
+namespace
+{
+const std::string cycles{"perf_thread_cpu_cycles"};
+const std::string instructions{"perf_thread_instructions"};
+
+// Returns an event with the given name, timestamp, vtid and counters in its stream event context.
+ctf::Event event(const std::string& name, std::int64_t timestamp, std::int64_t vtid, const std::map<std::string, std::uint64_t>& counters)
+{
+  ctf::Event result{name, 0, std::chrono::nanoseconds{timestamp}, ctf::Event::Fields{}};
+
+  auto add = [&result](const std::string& field, const ctf::Integer& value)
+  {
+    result.fields.insert(std::make_pair(
+        ctf::Event::Key{ctf::Scope::stream_event_context, field},
+        ctf::Field{field, ctf::Field::integer, value}));
+  };
+
+  add("vtid", ctf::Integer{vtid, 32, 10});
+  for (const auto& pair : counters)
+    add(pair.first, ctf::Integer{pair.second, 64, 10});
+
+  return result;
+}
+
+ctf::CounterDeltas deltas(const ctf::CounterDeltas::Handler& handler = ctf::CounterDeltas::Handler{})
+{
+  return ctf::CounterDeltas{"app:begin", "app:end", {cycles, instructions}, handler};
+}
+}
+
+BOOST_AUTO_TEST_CASE(a_pair_reports_the_increase_of_all_counters)
+{
+  std::vector<ctf::CounterDelta> pairs;
+  auto d = deltas([&pairs](const ctf::CounterDelta& delta) { pairs.push_back(delta); });
+
+  BOOST_CHECK(d.on_event(event("app:begin", 100, 7, {{cycles, 1000}, {instructions, 500}})));
+  BOOST_CHECK_EQUAL(1u, d.open());
+  BOOST_CHECK(d.on_event(event("app:end", 150, 7, {{cycles, 1400}, {instructions, 1300}})));
+  BOOST_CHECK_EQUAL(0u, d.open());
+
+  BOOST_REQUIRE_EQUAL(1u, pairs.size());
+  BOOST_CHECK_EQUAL(7, pairs[0].tid);
+  BOOST_CHECK(std::chrono::nanoseconds{100} == pairs[0].begin);
+  BOOST_CHECK(std::chrono::nanoseconds{50} == pairs[0].duration);
+  BOOST_CHECK_EQUAL(400u, pairs[0].counters.at(cycles));
+  BOOST_CHECK_EQUAL(800u, pairs[0].counters.at(instructions));
+
+  BOOST_CHECK_EQUAL(1u, d.totals().pairs);
+  BOOST_CHECK_CLOSE(2., d.totals().ratio(instructions, cycles), 1e-9);
+  BOOST_CHECK_CLOSE(400., d.totals().per_pair(cycles), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(pairs_nest_per_thread)
+{
+  std::vector<ctf::CounterDelta> pairs;
+  auto d = deltas([&pairs](const ctf::CounterDelta& delta) { pairs.push_back(delta); });
+
+  d.on_event(event("app:begin", 0, 1, {{cycles, 0}}));
+  d.on_event(event("app:begin", 10, 2, {{cycles, 0}}));
+  d.on_event(event("app:begin", 20, 1, {{cycles, 100}}));
+  d.on_event(event("app:end", 30, 1, {{cycles, 150}}));
+  d.on_event(event("app:end", 40, 2, {{cycles, 70}}));
+  d.on_event(event("app:end", 50, 1, {{cycles, 300}}));
+
+  BOOST_REQUIRE_EQUAL(3u, pairs.size());
+  BOOST_CHECK_EQUAL(1, pairs[0].tid);
+  BOOST_CHECK_EQUAL(50u, pairs[0].counters.at(cycles));
+  BOOST_CHECK_EQUAL(2, pairs[1].tid);
+  BOOST_CHECK_EQUAL(70u, pairs[1].counters.at(cycles));
+  BOOST_CHECK_EQUAL(1, pairs[2].tid);
+  BOOST_CHECK_EQUAL(300u, pairs[2].counters.at(cycles));
+
+  BOOST_CHECK_EQUAL(3u, d.totals().pairs);
+  BOOST_CHECK_EQUAL(420u, d.totals().counters.at(cycles));
+  BOOST_CHECK(std::chrono::nanoseconds{90} == d.totals().duration);
+}
+
+BOOST_AUTO_TEST_CASE(counters_missing_or_going_backwards_are_left_out)
+{
+  std::vector<ctf::CounterDelta> pairs;
+  auto d = deltas([&pairs](const ctf::CounterDelta& delta) { pairs.push_back(delta); });
+
+  d.on_event(event("app:begin", 0, 1, {{cycles, 100}, {instructions, 100}}));
+  d.on_event(event("app:end", 10, 1, {{cycles, 50}}));
+
+  BOOST_REQUIRE_EQUAL(1u, pairs.size());
+  BOOST_CHECK(pairs[0].counters.empty());
+  BOOST_CHECK_EQUAL(0., d.totals().ratio(instructions, cycles));
+}
+
+BOOST_AUTO_TEST_CASE(unrelated_and_unpaired_events_are_ignored)
+{
+  auto d = deltas();
+
+  BOOST_CHECK(not d.on_event(event("app:other", 0, 1, {{cycles, 0}})));
+  BOOST_CHECK(not d.on_event(event("app:end", 10, 1, {{cycles, 10}})));
+  BOOST_CHECK(not d.on_event(ctf::Event{"app:begin", 0, std::chrono::nanoseconds{20}, ctf::Event::Fields{}}));
+
+  BOOST_CHECK_EQUAL(0u, d.open());
+  BOOST_CHECK_EQUAL(0u, d.totals().pairs);
+  BOOST_CHECK_EQUAL(0., d.totals().per_pair(cycles));
+}
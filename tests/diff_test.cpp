@@ -0,0 +1,95 @@
+#define BOOST_TEST_MODULE diff
+#include <boost/test/unit_test.hpp>
+
+#include "generated_trace.h"
+
+#include <lttng/diff.h>
+
+#include <chrono>
+
+BOOST_AUTO_TEST_CASE(traces_of_the_same_shape_align)
+{
+  test::GeneratedTrace b{ctf::generator::Mix::mixed, 2000, 2};
+  test::GeneratedTrace c{ctf::generator::Mix::mixed, 2000, 2};
+  ctf::Trace baseline{b.path};
+  ctf::Trace candidate{c.path};
+
+  ctf::diff::Options options;
+  options.key_fields = {ctf::Event::Key{ctf::Scope::stream_packet_context, "cpu_id"}};
+
+  auto report = ctf::diff::compare(baseline, candidate, options);
+
+  BOOST_CHECK(not report.first_divergence);
+  BOOST_CHECK_EQUAL(2000u, report.baseline_events);
+  BOOST_CHECK_EQUAL(2000u, report.candidate_events);
+  BOOST_CHECK(not report.per_event_class.empty());
+
+  for (const auto& pair : report.per_event_class)
+  {
+    BOOST_CHECK_EQUAL(0, pair.second.delta());
+    BOOST_CHECK(std::chrono::nanoseconds::zero() == pair.second.shift(.5));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(different_event_classes_diverge_immediately)
+{
+  test::GeneratedTrace b{ctf::generator::Mix::libc, 110};
+  test::GeneratedTrace c{ctf::generator::Mix::pthread, 110};
+  ctf::Trace baseline{b.path};
+  ctf::Trace candidate{c.path};
+
+  auto report = ctf::diff::compare(baseline, candidate);
+
+  BOOST_REQUIRE(report.first_divergence);
+  BOOST_CHECK_EQUAL(0u, report.first_divergence->index);
+  BOOST_CHECK_EQUAL("ust_libc:malloc", report.first_divergence->baseline);
+  BOOST_CHECK_EQUAL("ust_pthread:pthread_mutex_lock_req", report.first_divergence->candidate);
+  BOOST_CHECK(std::chrono::nanoseconds::zero() == report.first_divergence->offset);
+}
+
+BOOST_AUTO_TEST_CASE(a_truncated_candidate_diverges_where_it_ends)
+{
+  test::GeneratedTrace b{ctf::generator::Mix::libc, 1100};
+  test::GeneratedTrace c{ctf::generator::Mix::libc, 1000};
+  ctf::Trace baseline{b.path};
+  ctf::Trace candidate{c.path};
+
+  auto report = ctf::diff::compare(baseline, candidate);
+
+  BOOST_CHECK_EQUAL(1100u, report.baseline_events);
+  BOOST_CHECK_EQUAL(1000u, report.candidate_events);
+  BOOST_CHECK_EQUAL(-18, report.per_event_class.at("ust_libc:malloc").delta());
+
+  // libc repeats a pattern of 11 events, the 1001st event is the last free of the pattern.
+  BOOST_REQUIRE(report.first_divergence);
+  BOOST_CHECK_EQUAL(1000u, report.first_divergence->index);
+  BOOST_CHECK_EQUAL("ust_libc:free", report.first_divergence->baseline);
+  BOOST_CHECK(report.first_divergence->candidate.empty());
+  BOOST_CHECK(std::chrono::nanoseconds{1000000} == report.first_divergence->offset);
+}
+
+BOOST_AUTO_TEST_CASE(exceeding_the_window_diverges_on_the_oldest_pending_event)
+{
+  // Stream 0 is identical in both traces, the events of stream 1 are never matched.
+  test::GeneratedTrace b{ctf::generator::Mix::libc, 2000, 2};
+  test::GeneratedTrace c{ctf::generator::Mix::libc, 1000, 1};
+  ctf::Trace baseline{b.path};
+  ctf::Trace candidate{c.path};
+
+  ctf::diff::Options options;
+  options.key_fields = {ctf::Event::Key{ctf::Scope::stream_packet_context, "cpu_id"}};
+  options.window = 10;
+
+  auto report = ctf::diff::compare(baseline, candidate, options);
+
+  BOOST_REQUIRE(report.first_divergence);
+  BOOST_CHECK_EQUAL("1;", report.first_divergence->key);
+  BOOST_CHECK_EQUAL(0u, report.first_divergence->index);
+  BOOST_CHECK_EQUAL("ust_libc:malloc", report.first_divergence->baseline);
+  BOOST_CHECK(report.first_divergence->candidate.empty());
+  BOOST_CHECK(std::chrono::nanoseconds{1} == report.first_divergence->offset);
+
+  // Counts and latencies keep being tracked past the divergence.
+  BOOST_CHECK_EQUAL(2000u, report.baseline_events);
+  BOOST_CHECK_EQUAL(1000u, report.candidate_events);
+}
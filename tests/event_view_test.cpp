@@ -0,0 +1,135 @@
+#define BOOST_TEST_MODULE event_view
+#include <boost/test/unit_test.hpp>
+
+#include "generated_trace.h"
+
+#include <lttng/event_view.h>
+#include <lttng/lttng.h>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+namespace libc = lttng::events::userspace::libc;
+
+typedef ctf::EventView<
+    ctf::view::Field<ctf::Scope::event_fields, std::uint64_t>,
+    ctf::view::Field<ctf::Scope::stream_event_context, std::int64_t>,
+    ctf::view::Field<ctf::Scope::stream_event_context, std::string>> MallocView;
+
+const MallocView::Names malloc_fields{{"size", "vpid", "procname"}};
+}
+
+BOOST_AUTO_TEST_CASE(a_view_decodes_the_requested_fields_of_its_event_class_only)
+{
+  // libc repeats a pattern of 11 events, 2 of them malloc.
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 1100};
+  ctf::Trace trace{generated.path};
+
+  std::uint64_t mallocs{0};
+  std::set<std::int64_t> vpids;
+  std::set<std::string> procnames;
+
+  MallocView view{libc::malloc, malloc_fields};
+  view.for_each_event(trace, [&](const MallocView::Values& values)
+  {
+    // Sizes are drawn from [1, 4096].
+    BOOST_CHECK_GE(std::get<0>(values), 1u);
+    BOOST_CHECK_LE(std::get<0>(values), 4096u);
+
+    vpids.insert(std::get<1>(values));
+    procnames.insert(std::get<2>(values));
+    mallocs++;
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(200u, mallocs);
+  BOOST_CHECK((std::set<std::int64_t>{1000, 1001} == vpids));
+  BOOST_CHECK((std::set<std::string>{"proc-0", "proc-1"} == procnames));
+}
+
+BOOST_AUTO_TEST_CASE(a_view_agrees_with_full_decoding_across_streams)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 2000, 2};
+  ctf::Trace trace{generated.path};
+
+  ctf::FieldSpec<ctf::Field::Type::integer> size{ctf::Scope::event_fields, "size"};
+  std::uint64_t expected{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    if (event.name == libc::malloc)
+      expected += size.interpret_or_throw(event).as_uint64();
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  // Ordering::none reads every stream through a babeltrace context of its own.
+  for (auto ordering : {ctf::Ordering::timestamp, ctf::Ordering::none})
+  {
+    std::uint64_t total{0};
+
+    MallocView view{libc::malloc, malloc_fields};
+    view.for_each_event(trace, [&total](const MallocView::Values& values)
+    {
+      total += std::get<0>(values);
+      return ctf::Trace::EventEnumeratorReply::ok;
+    }, ordering);
+
+    BOOST_CHECK_GT(total, 0u);
+    BOOST_CHECK_EQUAL(expected, total);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(enumerations_decode_into_their_values_and_floats_into_doubles)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::types, 12};
+  ctf::Trace trace{generated.path};
+
+  ctf::EventView<
+      ctf::view::Field<ctf::Scope::event_fields, int>,
+      ctf::view::Field<ctf::Scope::event_fields, double>> view{"ust_generator:types", {{"status", "ratio"}}};
+
+  std::uint64_t i{0};
+
+  view.for_each_event(trace, [&i](const std::tuple<int, double>& values)
+  {
+    BOOST_CHECK_EQUAL(i % 3 == 0 ? 16 : 0, std::get<0>(values));
+    BOOST_CHECK_EQUAL(i / 2., std::get<1>(values));
+
+    i++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(12u, i);
+}
+
+BOOST_AUTO_TEST_CASE(events_lacking_a_field_are_skipped)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 110};
+  ctf::Trace trace{generated.path};
+
+  ctf::EventView<ctf::view::Field<ctf::Scope::event_fields, std::uint64_t>> view{libc::malloc, {{"nmemb"}}};
+  std::uint64_t events{0};
+
+  view.for_each_event(trace, [&events](const std::tuple<std::uint64_t>&)
+  {
+    events++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(0u, events);
+}
+
+BOOST_AUTO_TEST_CASE(fields_that_cannot_be_decoded_into_the_requested_type_throw)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 110};
+  ctf::Trace trace{generated.path};
+
+  ctf::EventView<ctf::view::Field<ctf::Scope::event_fields, std::string>> view{libc::malloc, {{"size"}}};
+
+  BOOST_CHECK_THROW(view.for_each_event(trace, [](const std::tuple<std::string>&) { return ctf::Trace::EventEnumeratorReply::ok; }), std::runtime_error);
+}
@@ -0,0 +1,53 @@
+#ifndef LTTNG_TESTS_GENERATED_TRACE_H_
+#define LTTNG_TESTS_GENERATED_TRACE_H_
+
+#include <lttng/generator.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+
+namespace test
+{
+/// @brief GeneratedTrace writes a synthetic trace to a uniquely named directory, which is removed on destruction.
+///
+/// Streams carry packets of 4 KiB, such that even small traces span many packets,
+/// and events are 1 us apart. Streams are offset from each other by 1 ns.
+struct GeneratedTrace
+{
+  GeneratedTrace(ctf::generator::Mix mix, std::uint64_t events, std::uint32_t streams = 1, std::uint32_t processes = 2)
+      : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-test-%%%%-%%%%")),
+        summary(ctf::generator::generate(path, ctf::generator::Shape{events, 0, streams, packet_size, processes, 1000000, 42, mix}, 1))
+  {
+  }
+
+  GeneratedTrace(const GeneratedTrace&) = delete;
+
+  ~GeneratedTrace()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(path, ec);
+  }
+
+  GeneratedTrace& operator=(const GeneratedTrace&) = delete;
+
+  /// @brief stream returns the path of the stream file of the given cpu.
+  boost::filesystem::path stream(std::uint32_t cpu) const
+  {
+    return path / ("channel0_" + std::to_string(cpu));
+  }
+
+  /// @brief packets returns the number of packets in the stream file of the given cpu.
+  std::uint64_t packets(std::uint32_t cpu) const
+  {
+    return boost::filesystem::file_size(stream(cpu)) / packet_size;
+  }
+
+  static constexpr const std::uint32_t packet_size{4096};
+
+  boost::filesystem::path path;
+  ctf::generator::Summary summary;
+};
+}
+
+#endif // LTTNG_TESTS_GENERATED_TRACE_H_
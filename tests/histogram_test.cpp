@@ -0,0 +1,62 @@
+#define BOOST_TEST_MODULE histogram
+#include <boost/test/unit_test.hpp>
+
+#include <lttng/histogram.h>
+
+BOOST_AUTO_TEST_CASE(an_empty_histogram_reports_zero_for_all_quantiles)
+{
+  lttng::Histogram histogram;
+
+  BOOST_CHECK_EQUAL(0u, histogram.count);
+  BOOST_CHECK(std::chrono::nanoseconds{0} == histogram.quantile(0.));
+  BOOST_CHECK(std::chrono::nanoseconds{0} == histogram.quantile(.5));
+  BOOST_CHECK(std::chrono::nanoseconds{0} == histogram.quantile(1.));
+}
+
+BOOST_AUTO_TEST_CASE(durations_are_recorded_in_power_of_two_buckets)
+{
+  lttng::Histogram histogram;
+
+  histogram.add(std::chrono::nanoseconds{0});
+  histogram.add(std::chrono::nanoseconds{1});
+  histogram.add(std::chrono::nanoseconds{2});
+  histogram.add(std::chrono::nanoseconds{100});
+
+  BOOST_CHECK_EQUAL(4u, histogram.count);
+  BOOST_CHECK_EQUAL(1u, histogram.buckets[0]);
+  BOOST_CHECK_EQUAL(2u, histogram.buckets[1]);
+  BOOST_CHECK_EQUAL(1u, histogram.buckets[6]);
+}
+
+BOOST_AUTO_TEST_CASE(negative_durations_are_recorded_as_zero)
+{
+  lttng::Histogram histogram;
+  histogram.add(std::chrono::nanoseconds{-42});
+
+  BOOST_CHECK_EQUAL(1u, histogram.buckets[0]);
+}
+
+BOOST_AUTO_TEST_CASE(huge_durations_saturate_at_the_last_bucket)
+{
+  lttng::Histogram histogram;
+  histogram.add(std::chrono::nanoseconds::max());
+
+  BOOST_CHECK_EQUAL(1u, histogram.buckets.back());
+  BOOST_CHECK(std::chrono::nanoseconds::max() == histogram.quantile(1.));
+}
+
+BOOST_AUTO_TEST_CASE(quantiles_report_the_upper_bound_of_their_bucket)
+{
+  lttng::Histogram histogram;
+
+  for (int i = 0; i < 99; i++)
+    histogram.add(std::chrono::nanoseconds{10});
+  histogram.add(std::chrono::nanoseconds{1000});
+
+  // 10 + 1 is in [8, 16), 1000 + 1 is in [512, 1024).
+  BOOST_CHECK(std::chrono::nanoseconds{14} == histogram.quantile(0.));
+  BOOST_CHECK(std::chrono::nanoseconds{14} == histogram.quantile(.5));
+  BOOST_CHECK(std::chrono::nanoseconds{14} == histogram.quantile(.99));
+  BOOST_CHECK(std::chrono::nanoseconds{1022} == histogram.quantile(1.));
+  BOOST_CHECK(std::chrono::nanoseconds{1022} == histogram.quantile(2.));
+}
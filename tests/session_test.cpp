@@ -0,0 +1,230 @@
+#define BOOST_TEST_MODULE session
+#include <boost/test/unit_test.hpp>
+
+#include <lttng/lttng.h>
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+// TemporaryDirectory is a uniquely named directory that is removed on destruction.
+struct TemporaryDirectory
+{
+  TemporaryDirectory()
+      : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lttng-test-%%%%-%%%%"))
+  {
+    boost::filesystem::create_directories(path);
+  }
+
+  ~TemporaryDirectory()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(path, ec);
+  }
+
+  boost::filesystem::path path;
+};
+
+// Returns the commands of the given calls, in order.
+std::vector<lttng::Command> commands(const std::vector<lttng::RecordingControlBackend::Call>& calls)
+{
+  std::vector<lttng::Command> result;
+
+  for (const auto& call : calls)
+    result.push_back(call.command);
+
+  return result;
+}
+
+lttng::SessionConfig config_for(const std::shared_ptr<lttng::Consumer>& consumer)
+{
+  auto channel = lttng::Channel::defaults(lttng::Domain::userspace, "requests");
+  channel.subbuffer_size = 1024 * 1024;
+  channel.subbuffer_count = 8;
+  channel.mode = lttng::Channel::Mode::overwrite;
+
+  lttng::EventRule rule{"app:*"};
+  rule.log_level_match = lttng::EventRule::LogLevelMatch::range;
+  rule.log_level = lttng::LogLevel::warning;
+  rule.exclusions = {"app:noisy"};
+
+  lttng::SessionConfig config{lttng::Domain::userspace, "test", consumer};
+  config.channel(channel)
+        .add_context(lttng::Context::vtid)
+        .add_context(lttng::PerfCounter::cpu_cycles)
+        .enable_event("ust_libc:malloc", "size > 4096")
+        .enable_event(rule);
+
+  return config;
+}
+}
+
+BOOST_AUTO_TEST_CASE(a_session_issues_its_commands_in_order)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+
+  {
+    auto tracer = lttng::Tracer::create(lttng::Domain::userspace, backend);
+    auto session = tracer->create_session("test", std::make_shared<lttng::FileSystemConsumer>(dir.path));
+
+    session->enable_event("ust_libc:malloc");
+    session->start();
+    session->stop();
+  }
+
+  auto calls = backend->calls();
+  std::vector<lttng::Command> expected
+  {
+    lttng::Command::create_session,
+    lttng::Command::enable_event,
+    lttng::Command::start,
+    lttng::Command::stop,
+    lttng::Command::destroy_session
+  };
+
+  BOOST_CHECK(expected == commands(calls));
+  BOOST_CHECK_EQUAL("test", calls.front().session);
+  BOOST_CHECK_EQUAL("file://" + dir.path.string(), calls.front().arguments.at(0));
+}
+
+BOOST_AUTO_TEST_CASE(a_session_config_survives_a_round_trip_through_its_xml)
+{
+  TemporaryDirectory dir;
+  auto config = config_for(std::make_shared<lttng::FileSystemConsumer>(dir.path / "trace"));
+
+  config.save(dir.path / "session.lttng");
+  auto loaded = lttng::SessionConfig::load(dir.path / "session.lttng");
+
+  BOOST_CHECK_EQUAL(config.to_xml(), loaded.to_xml());
+  BOOST_CHECK_EQUAL("test", loaded.name());
+  BOOST_CHECK(lttng::Domain::userspace == loaded.domain());
+
+  BOOST_REQUIRE_EQUAL(1u, loaded.channels().size());
+  const auto& channel = loaded.channels().front();
+
+  BOOST_CHECK_EQUAL("requests", channel.channel.name);
+  BOOST_CHECK_EQUAL(1024u * 1024u, channel.channel.subbuffer_size);
+  BOOST_CHECK_EQUAL(8u, channel.channel.subbuffer_count);
+  BOOST_CHECK(lttng::Channel::Mode::overwrite == channel.channel.mode);
+  BOOST_REQUIRE_EQUAL(1u, channel.contexts.size());
+  BOOST_CHECK(lttng::Context::vtid == channel.contexts.front());
+  BOOST_REQUIRE_EQUAL(1u, channel.perf_counters.size());
+  BOOST_CHECK(lttng::PerfCounter::cpu_cycles == channel.perf_counters.front());
+  BOOST_REQUIRE_EQUAL(2u, channel.events.size());
+  BOOST_CHECK_EQUAL("size > 4096", channel.events[0].filter);
+  BOOST_CHECK(lttng::EventRule::LogLevelMatch::range == channel.events[1].log_level_match);
+  BOOST_CHECK(lttng::LogLevel::warning == channel.events[1].log_level);
+  BOOST_CHECK(std::vector<std::string>{"app:noisy"} == channel.events[1].exclusions);
+}
+
+BOOST_AUTO_TEST_CASE(a_session_created_from_a_config_loads_its_description)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+  auto config = config_for(std::make_shared<lttng::FileSystemConsumer>(dir.path));
+
+  lttng::Tracer::create(lttng::Domain::userspace, backend)->create_session(config);
+
+  auto calls = backend->calls();
+
+  BOOST_REQUIRE_EQUAL(2u, calls.size());
+  BOOST_CHECK(lttng::Command::load_session == calls[0].command);
+  BOOST_CHECK_EQUAL(config.to_xml(), calls[0].arguments.at(0));
+  BOOST_CHECK(lttng::Command::destroy_session == calls[1].command);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_count_calls_and_failures_per_command)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+  auto session = std::make_shared<lttng::Session>(
+      lttng::Domain::userspace, "test", std::make_shared<lttng::FileSystemConsumer>(dir.path), backend);
+
+  session->start();
+  session->stop();
+  session->start();
+
+  auto metrics = backend->metrics();
+
+  BOOST_CHECK_EQUAL(1u, metrics.at(lttng::Command::create_session).calls);
+  BOOST_CHECK_EQUAL(2u, metrics.at(lttng::Command::start).calls);
+  BOOST_CHECK_EQUAL(2u, metrics.at(lttng::Command::start).latency.count);
+  BOOST_CHECK_EQUAL(0u, metrics.at(lttng::Command::start).failures);
+  BOOST_CHECK_EQUAL(1u, metrics.at(lttng::Command::stop).calls);
+  BOOST_CHECK_EQUAL(0u, metrics.count(lttng::Command::rotate));
+
+  backend->reset_metrics();
+  BOOST_CHECK(backend->metrics().empty());
+}
+
+BOOST_AUTO_TEST_CASE(injected_failures_surface_as_exceptions_and_are_counted)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+  auto session = std::make_shared<lttng::Session>(
+      lttng::Domain::userspace, "test", std::make_shared<lttng::FileSystemConsumer>(dir.path), backend);
+
+  backend->fail(lttng::Command::start, -42);
+
+  try
+  {
+    session->start();
+    BOOST_FAIL("start did not throw");
+  }
+  catch (const lttng::Exception& e)
+  {
+    BOOST_CHECK_EQUAL(-42, e.code);
+  }
+
+  BOOST_CHECK_NO_THROW(session->stop());
+
+  auto metrics = backend->metrics();
+  BOOST_CHECK_EQUAL(1u, metrics.at(lttng::Command::start).calls);
+  BOOST_CHECK_EQUAL(1u, metrics.at(lttng::Command::start).failures);
+  BOOST_CHECK_EQUAL(0u, metrics.at(lttng::Command::stop).failures);
+}
+
+BOOST_AUTO_TEST_CASE(rotate_returns_the_archived_chunk)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+  lttng::Session session{lttng::Domain::userspace, "test", std::make_shared<lttng::FileSystemConsumer>(dir.path), backend};
+
+  auto first = session.rotate();
+  auto second = session.rotate();
+
+  BOOST_CHECK(first != second);
+  BOOST_CHECK(boost::filesystem::is_directory(first));
+  BOOST_CHECK(boost::filesystem::is_directory(second));
+  BOOST_CHECK(dir.path / "archives" == first.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(rotation_schedules_are_replaced_and_disabled)
+{
+  TemporaryDirectory dir;
+  auto backend = std::make_shared<lttng::RecordingControlBackend>();
+
+  {
+    lttng::Session session{lttng::Domain::userspace, "test", std::make_shared<lttng::FileSystemConsumer>(dir.path), backend};
+
+    BOOST_CHECK_THROW(session.enable_rotation(lttng::RotationSchedule{}), std::runtime_error);
+
+    session.enable_rotation(lttng::RotationSchedule::every(std::chrono::seconds{1}));
+    session.enable_rotation(lttng::RotationSchedule::larger_than(4096));
+    session.disable_rotation();
+    session.disable_rotation();
+  }
+
+  std::vector<lttng::Command> expected
+  {
+    lttng::Command::create_session,
+    lttng::Command::enable_rotation,
+    lttng::Command::disable_rotation,
+    lttng::Command::enable_rotation,
+    lttng::Command::disable_rotation,
+    lttng::Command::destroy_session
+  };
+
+  BOOST_CHECK(expected == commands(backend->calls()));
+}
@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE symbolizer
+#include <boost/test/unit_test.hpp>
+
+#include "generated_trace.h"
+
+#include <lttng/lttng.h>
+#include <lttng/symbolizer.h>
+
+#include <dlfcn.h>
+
+#include <cstdint>
+
+extern "C" __attribute__((noinline)) int lttng_symbolizer_test_function(int value)
+{
+  // Keeps the call from being folded into the caller.
+  asm volatile("" : "+r"(value));
+  return value + 1;
+}
+
+BOOST_AUTO_TEST_CASE(addresses_resolve_to_symbols_of_the_object_they_are_mapped_from)
+{
+  BOOST_REQUIRE_EQUAL(42, lttng_symbolizer_test_function(41));
+
+  Dl_info info;
+  auto address = reinterpret_cast<std::uint64_t>(&lttng_symbolizer_test_function);
+  BOOST_REQUIRE(dladdr(reinterpret_cast<void*>(address), &info) != 0);
+
+  auto base = reinterpret_cast<std::uint64_t>(info.dli_fbase);
+  auto executable = boost::filesystem::read_symlink("/proc/self/exe");
+
+  ctf::Symbolizer symbolizer;
+  symbolizer.add_object(1, base, address - base + 0x1000000, executable.string());
+
+  auto symbol = symbolizer.resolve(1, address + 1);
+  BOOST_REQUIRE(symbol != nullptr);
+  BOOST_CHECK_EQUAL("lttng_symbolizer_test_function", symbol->name);
+  BOOST_CHECK_EQUAL(1u, symbol->offset);
+  BOOST_CHECK(executable == symbol->object);
+
+  // Resolved symbols are cached.
+  BOOST_CHECK_EQUAL(symbol, symbolizer.resolve(1, address + 1));
+
+  // Addresses outside of any mapping, or of other processes, do not resolve.
+  BOOST_CHECK(symbolizer.resolve(1, base - 1) == nullptr);
+  BOOST_CHECK(symbolizer.resolve(2, address) == nullptr);
+
+  // Mappings overlapping a new one are replaced.
+  symbolizer.add_object(1, base, 0x1000, "/does/not/exist");
+  BOOST_CHECK(symbolizer.resolve(1, address) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(soinfo_events_are_recorded_as_objects)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::strings, 128};
+  ctf::Trace trace{generated.path};
+
+  ctf::Symbolizer symbolizer;
+  std::uint64_t recorded{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    if (symbolizer.on_event(event))
+      recorded++;
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(128u, recorded);
+
+  // The generated objects do not exist, such that addresses within them do not resolve.
+  BOOST_CHECK(symbolizer.resolve(1000, 0x7f1000000000 + 16) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(events_without_a_known_object_do_not_resolve)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 110};
+  ctf::Trace trace{generated.path};
+
+  ctf::Symbolizer symbolizer;
+  std::uint64_t events{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    BOOST_CHECK(not symbolizer.on_event(event));
+    BOOST_CHECK(symbolizer.resolve(event) == nullptr);
+    events++;
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(110u, events);
+}
@@ -0,0 +1,458 @@
+#define BOOST_TEST_MODULE trace
+#include <boost/test/unit_test.hpp>
+
+#include "generated_trace.h"
+
+#include <lttng/ctf.h>
+#include <lttng/lttng.h>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+namespace libc = lttng::events::userspace::libc;
+
+const ctf::FieldSpec<ctf::Field::Type::integer> cpu_id{ctf::Scope::stream_packet_context, "cpu_id"};
+
+// Returns the number of events of the given trace, walked in the given order.
+std::uint64_t count(ctf::Trace& trace, ctf::Ordering ordering = ctf::Ordering::timestamp)
+{
+  std::uint64_t result{0};
+
+  trace.for_each_event([&result](const ctf::Event&)
+  {
+    result++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ordering);
+
+  return result;
+}
+
+// Returns the number of events handed out per event class by an iteration with the given sampling.
+std::map<std::string, std::uint64_t> count_per_event_class(ctf::Trace& trace, const ctf::Sampling& sampling, ctf::SamplingReport& report)
+{
+  std::map<std::string, std::uint64_t> result;
+
+  report = trace.for_each_event([&result](const ctf::Event& event)
+  {
+    result[event.name]++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, sampling);
+
+  return result;
+}
+
+std::string read_file(const boost::filesystem::path& path)
+{
+  boost::filesystem::ifstream in{path, std::ios::binary};
+  return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(all_generated_events_are_walked)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 1000, 2};
+  ctf::Trace trace{generated.path};
+
+  BOOST_CHECK_EQUAL(1000u, generated.summary.events);
+  BOOST_CHECK_EQUAL(generated.summary.events, count(trace));
+}
+
+BOOST_AUTO_TEST_CASE(timestamp_ordering_merges_all_streams)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 1000, 2};
+  ctf::Trace trace{generated.path};
+
+  std::uint64_t switches{0};
+  boost::optional<std::uint64_t> last_cpu;
+  std::chrono::nanoseconds last_timestamp{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    auto cpu = cpu_id.interpret_or_throw(event).as_uint64();
+
+    BOOST_CHECK(last_timestamp <= event.timestamp);
+    if (last_cpu && *last_cpu != cpu)
+      switches++;
+
+    last_cpu = cpu;
+    last_timestamp = event.timestamp;
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ctf::Ordering::timestamp);
+
+  // Events of both streams are 1 ns apart and alternate.
+  BOOST_CHECK_EQUAL(999u, switches);
+}
+
+BOOST_AUTO_TEST_CASE(no_ordering_walks_streams_one_after_another)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 1000, 2};
+  ctf::Trace trace{generated.path};
+
+  std::map<std::uint64_t, std::uint64_t> per_cpu;
+  std::uint64_t switches{0};
+  boost::optional<std::uint64_t> last_cpu;
+  std::chrono::nanoseconds last_timestamp{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    auto cpu = cpu_id.interpret_or_throw(event).as_uint64();
+
+    if (last_cpu && *last_cpu != cpu)
+      switches++;
+    else
+      BOOST_CHECK(last_timestamp <= event.timestamp);
+
+    per_cpu[cpu]++;
+    last_cpu = cpu;
+    last_timestamp = event.timestamp;
+
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ctf::Ordering::none);
+
+  BOOST_CHECK_EQUAL(1u, switches);
+  BOOST_REQUIRE_EQUAL(2u, per_cpu.size());
+  BOOST_CHECK_EQUAL(500u, per_cpu[0]);
+  BOOST_CHECK_EQUAL(500u, per_cpu[1]);
+}
+
+BOOST_AUTO_TEST_CASE(enumeration_stops_when_asked_to)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 100};
+  ctf::Trace trace{generated.path};
+
+  for (auto ordering : {ctf::Ordering::timestamp, ctf::Ordering::none})
+  {
+    std::uint64_t events{0};
+
+    trace.for_each_event([&events](const ctf::Event&)
+    {
+      return ++events == 10 ? ctf::Trace::EventEnumeratorReply::stop : ctf::Trace::EventEnumeratorReply::ok;
+    }, ordering);
+
+    BOOST_CHECK_EQUAL(10u, events);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(every_nth_sampling_hands_out_the_first_and_every_nth_event_per_event_class)
+{
+  // libc repeats a pattern of 11 events: 2 malloc, 5 free and one of every other event class.
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 1100};
+  ctf::Trace trace{generated.path};
+
+  ctf::SamplingReport report;
+  auto delivered = count_per_event_class(trace, ctf::Sampling::every_nth_per_event_class(10), report);
+
+  BOOST_CHECK_EQUAL(20u, delivered[libc::malloc]);
+  BOOST_CHECK_EQUAL(50u, delivered[libc::free]);
+  BOOST_CHECK_EQUAL(10u, delivered[libc::calloc]);
+
+  BOOST_CHECK_EQUAL(1100u, report.events.seen);
+  BOOST_CHECK_EQUAL(110u, report.events.delivered);
+  BOOST_CHECK_EQUAL(200u, report.per_event_class.at(libc::malloc).seen);
+  BOOST_CHECK_EQUAL(20u, report.per_event_class.at(libc::malloc).delivered);
+  BOOST_CHECK_CLOSE(10., report.per_event_class.at(libc::malloc).scale(), 1e-9);
+  BOOST_CHECK_CLOSE(.1, report.events.rate(), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(bernoulli_sampling_is_reproducible)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 1100};
+  ctf::Trace trace{generated.path};
+
+  auto timestamps = [&trace]()
+  {
+    std::vector<std::chrono::nanoseconds> result;
+
+    trace.for_each_event([&result](const ctf::Event& event)
+    {
+      result.push_back(event.timestamp);
+      return ctf::Trace::EventEnumeratorReply::ok;
+    }, ctf::Sampling::bernoulli(.3, 7));
+
+    return result;
+  };
+
+  auto first = timestamps();
+  auto second = timestamps();
+
+  BOOST_CHECK(not first.empty());
+  BOOST_CHECK_LT(first.size(), 1100u);
+  BOOST_CHECK(first == second);
+}
+
+BOOST_AUTO_TEST_CASE(sampling_nothing_reports_a_scale_of_zero)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 1100};
+  ctf::Trace trace{generated.path};
+
+  ctf::SamplingReport report;
+  auto delivered = count_per_event_class(trace, ctf::Sampling::bernoulli(0., 1), report);
+
+  BOOST_CHECK(delivered.empty());
+  BOOST_CHECK_EQUAL(1100u, report.events.seen);
+  BOOST_CHECK_EQUAL(0u, report.events.delivered);
+  BOOST_CHECK_EQUAL(0., report.events.rate());
+  BOOST_CHECK_EQUAL(0., report.events.scale());
+
+  delivered = count_per_event_class(trace, ctf::Sampling::bernoulli(1., 1), report);
+
+  BOOST_CHECK_EQUAL(1100u, report.events.delivered);
+  BOOST_CHECK_EQUAL(1., report.events.scale());
+}
+
+BOOST_AUTO_TEST_CASE(packet_sampling_hands_out_all_events_of_every_nth_packet_per_stream)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 4000, 2};
+  ctf::Trace trace{generated.path};
+
+  ctf::SamplingReport report;
+  std::uint64_t delivered{0};
+
+  report = trace.for_each_event([&delivered](const ctf::Event&)
+  {
+    delivered++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  }, ctf::Sampling::packets(2));
+
+  auto p0 = generated.packets(0), p1 = generated.packets(1);
+
+  BOOST_REQUIRE_GT(p0, 2u);
+  BOOST_CHECK_EQUAL(p0 + p1, report.packets.seen);
+  BOOST_CHECK_EQUAL((p0 + 1) / 2 + (p1 + 1) / 2, report.packets.delivered);
+  BOOST_CHECK_EQUAL(4000u, report.events.seen);
+  BOOST_CHECK_EQUAL(delivered, report.events.delivered);
+  BOOST_CHECK_LT(delivered, 4000u);
+}
+
+BOOST_AUTO_TEST_CASE(instrumentation_records_statistics_of_the_last_iteration)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 4000, 2};
+  ctf::Trace trace{generated.path};
+
+  std::vector<std::uint64_t> progress;
+  trace.enable_instrumentation(ctf::Instrumentation
+  {
+    [&progress](const ctf::Statistics& statistics) { progress.push_back(statistics.events); },
+    std::chrono::milliseconds{0}
+  });
+
+  BOOST_CHECK_EQUAL(4000u, count(trace));
+
+  auto statistics = trace.statistics();
+  BOOST_CHECK_EQUAL(4000u, statistics.events);
+  BOOST_CHECK_EQUAL(4000u, statistics.decoded_events);
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(generated.stream(0)) + boost::filesystem::file_size(generated.stream(1)), statistics.bytes);
+  BOOST_CHECK(statistics.reader_time() <= statistics.elapsed);
+
+  std::uint64_t per_event_class{0};
+  for (const auto& pair : statistics.per_event_class)
+    per_event_class += pair.second;
+  BOOST_CHECK_EQUAL(4000u, per_event_class);
+
+  BOOST_REQUIRE_EQUAL(2u, statistics.packets_per_stream.size());
+  BOOST_CHECK_EQUAL(generated.packets(0), statistics.packets_per_stream.at(std::make_tuple(std::uint64_t{0}, std::uint64_t{0})));
+  BOOST_CHECK_EQUAL(generated.packets(1), statistics.packets_per_stream.at(std::make_tuple(std::uint64_t{0}, std::uint64_t{1})));
+
+  // Progress is checked every 1024 events.
+  BOOST_REQUIRE(not progress.empty());
+  for (auto events : progress)
+    BOOST_CHECK_EQUAL(0u, events % 1024);
+
+  // Sampled events are walked, but not decoded.
+  trace.for_each_event([](const ctf::Event&) { return ctf::Trace::EventEnumeratorReply::ok; }, ctf::Sampling::every_nth_per_event_class(10));
+  BOOST_CHECK_EQUAL(4000u, trace.statistics().events);
+  BOOST_CHECK_LT(trace.statistics().decoded_events, 4000u);
+
+  // Iterations without instrumentation leave the last statistics untouched.
+  trace.disable_instrumentation();
+  auto last = trace.statistics().decoded_events;
+  BOOST_CHECK_EQUAL(4000u, count(trace));
+  BOOST_CHECK_EQUAL(last, trace.statistics().decoded_events);
+}
+
+BOOST_AUTO_TEST_CASE(strings_and_char_arrays_decode_into_string_views)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::strings, 300};
+  ctf::Trace trace{generated.path};
+
+  ctf::FieldSpec<ctf::Field::Type::string> sopath{ctf::Scope::event_fields, "sopath"};
+  ctf::FieldSpec<ctf::Field::Type::string> procname{ctf::Scope::stream_event_context, "procname"};
+  std::uint64_t i{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    BOOST_REQUIRE(sopath.available_in(event));
+    BOOST_CHECK_EQUAL("/usr/lib/x86_64-linux-gnu/libgenerated-" + std::to_string(i % 128) + ".so.1", sopath.interpret_or_throw(event).str());
+
+    // procname is a fixed-size array of characters, padded with null characters.
+    BOOST_REQUIRE(procname.available_in(event));
+    BOOST_CHECK_EQUAL("proc-" + std::to_string(i / 64 % 2), procname.interpret_or_throw(event).str());
+    BOOST_CHECK_EQUAL(ctf::Field::Type::array, event.fields.at(ctf::Event::Key{ctf::Scope::stream_event_context, "procname"}).type());
+
+    i++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(300u, i);
+}
+
+BOOST_AUTO_TEST_CASE(integer_arrays_and_sequences_decode_into_contiguous_buffers)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::types, 12};
+  ctf::Trace trace{generated.path};
+
+  ctf::FieldSpec<ctf::Field::Type::uint64_array> callstack{ctf::Scope::event_fields, "callstack"};
+  ctf::FieldSpec<ctf::Field::Type::byte_array> digest{ctf::Scope::event_fields, "digest"};
+  ctf::FieldSpec<ctf::Field::Type::byte_array> uuid{ctf::Scope::trace_packet_header, "uuid"};
+  std::uint64_t i{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    // Every fourth callstack is empty, and still reads as an empty buffer.
+    BOOST_REQUIRE(callstack.available_in(event));
+    const auto& frames = callstack.interpret_or_throw(event);
+    BOOST_REQUIRE_EQUAL(i % 4, frames.size());
+    for (std::size_t j = 0; j < frames.size(); j++)
+      BOOST_CHECK_EQUAL(0x400000u + 16 * j, frames[j]);
+
+    BOOST_REQUIRE(digest.available_in(event));
+    BOOST_CHECK((std::vector<std::uint8_t>{std::uint8_t(i), std::uint8_t(i + 1), std::uint8_t(i + 2), std::uint8_t(i + 3)} == digest.interpret_or_throw(event)));
+
+    // Contiguous arrays do not match Type::array.
+    const auto& field = event.fields.at(ctf::Event::Key{ctf::Scope::event_fields, "digest"});
+    BOOST_CHECK_EQUAL(ctf::Field::Type::array, field.type());
+    BOOST_CHECK(not field.is_a(ctf::Field::Type::array));
+    BOOST_CHECK(not field.is_a(ctf::Field::Type::uint64_array));
+
+    BOOST_REQUIRE(uuid.available_in(event));
+    BOOST_CHECK_EQUAL(16u, uuid.interpret_or_throw(event).size());
+
+    BOOST_CHECK_EQUAL(i / 2., event.fields.at(ctf::Event::Key{ctf::Scope::event_fields, "ratio"}).as_floating_point());
+
+    i++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(12u, i);
+}
+
+BOOST_AUTO_TEST_CASE(enumerations_decode_into_labels_and_values)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::types, 12};
+  ctf::Trace trace{generated.path};
+
+  ctf::FieldSpec<ctf::Field::Type::enumeration> status{ctf::Scope::event_fields, "status"};
+  std::uint64_t i{0};
+
+  trace.for_each_event([&](const ctf::Event& event)
+  {
+    BOOST_REQUIRE(status.available_in(event));
+    const auto& enumerator = status.interpret_or_throw(event);
+
+    BOOST_CHECK_EQUAL(i % 3 == 0 ? "busy" : "ok", enumerator.as_string.str());
+    BOOST_CHECK_EQUAL(i % 3 == 0 ? 16u : 0u, enumerator.as_integer.as_uint64());
+
+    i++;
+    return ctf::Trace::EventEnumeratorReply::ok;
+  });
+
+  BOOST_CHECK_EQUAL(12u, i);
+}
+
+BOOST_AUTO_TEST_CASE(traces_load_from_buffers_and_files_held_in_memory)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::mixed, 1000, 2};
+
+  auto metadata = read_file(generated.path / "metadata");
+  auto stream0 = read_file(generated.stream(0));
+  auto stream1 = read_file(generated.stream(1));
+
+  {
+    ctf::Trace trace
+    {
+      ctf::Trace::Buffer{metadata.data(), metadata.size()},
+      ctf::Trace::StreamBuffers
+      {
+        {"channel0_0", ctf::Trace::Buffer{stream0.data(), stream0.size()}},
+        {"channel0_1", ctf::Trace::Buffer{stream1.data(), stream1.size()}}
+      }
+    };
+
+    BOOST_CHECK_EQUAL(1000u, count(trace));
+  }
+
+  int fds[3]
+  {
+    ::open((generated.path / "metadata").c_str(), O_RDONLY | O_CLOEXEC),
+    ::open(generated.stream(0).c_str(), O_RDONLY | O_CLOEXEC),
+    ::open(generated.stream(1).c_str(), O_RDONLY | O_CLOEXEC)
+  };
+
+  {
+    ctf::Trace trace{fds[0], ctf::Trace::StreamFiles{{"channel0_0", fds[1]}, {"channel0_1", fds[2]}}};
+    BOOST_CHECK_EQUAL(1000u, count(trace));
+  }
+
+  // Descriptors remain owned by the caller.
+  for (auto fd : fds)
+    BOOST_CHECK_EQUAL(0, ::close(fd));
+}
+
+BOOST_AUTO_TEST_CASE(traces_held_in_memory_reject_invalid_streams)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 100};
+  auto metadata = read_file(generated.path / "metadata");
+  ctf::Trace::Buffer buffer{metadata.data(), metadata.size()};
+
+  BOOST_CHECK_THROW((ctf::Trace{buffer, ctf::Trace::StreamBuffers{{"metadata", buffer}}}), std::invalid_argument);
+  BOOST_CHECK_THROW((ctf::Trace{buffer, ctf::Trace::StreamBuffers{{"../channel0_0", buffer}}}), std::invalid_argument);
+  BOOST_CHECK_THROW((ctf::Trace{-1, ctf::Trace::StreamFiles{}}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_routes_events_to_interested_analyses_only)
+{
+  test::GeneratedTrace generated{ctf::generator::Mix::libc, 1100};
+  ctf::Trace trace{generated.path};
+
+  const ctf::Event::Key size{ctf::Scope::event_fields, "size"};
+  const ctf::Event::Key ptr{ctf::Scope::event_fields, "ptr"};
+  std::uint64_t mallocs{0}, frees{0}, all{0};
+
+  ctf::Dispatcher dispatcher;
+
+  dispatcher.add(ctf::Dispatcher::Interest{{libc::malloc}, {size}, false}, [&](const ctf::Event& event)
+  {
+    BOOST_CHECK_EQUAL(libc::malloc, event.name);
+    BOOST_CHECK(event.fields.count(size));
+    mallocs++;
+  });
+
+  dispatcher.add(ctf::Dispatcher::Interest{{libc::free}, {}, true}, [&](const ctf::Event& event)
+  {
+    BOOST_CHECK_EQUAL(libc::free, event.name);
+    BOOST_CHECK(event.fields.count(ptr));
+    frees++;
+  });
+
+  dispatcher.add(ctf::Dispatcher::Interest{{}, {}, false}, [&](const ctf::Event&)
+  {
+    all++;
+  });
+
+  dispatcher.run(trace);
+
+  BOOST_CHECK_EQUAL(200u, mallocs);
+  BOOST_CHECK_EQUAL(500u, frees);
+  BOOST_CHECK_EQUAL(1100u, all);
+}
@@ -0,0 +1,85 @@
+#include <lttng/generator.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+void print_usage(const char* name)
+{
+  std::cerr << "Usage: " << name << " --output=DIR [--events=N] [--bytes=N] [--streams=N] [--packet-size=N]" << "\n"
+            << "       [--processes=N] [--events-per-second=N] [--seed=N] [--mix=libc|pthread|mixed|strings|types] [--threads=N]" << std::endl;
+}
+}
+
+// Call like: ./lttng-generate-trace --output=/tmp/generated --bytes=10000000000 --streams=16
+int main(int argc, char** argv)
+{
+  auto shape = ctf::generator::default_shape();
+  boost::filesystem::path output;
+  unsigned int threads{0};
+  bool events_given{false};
+
+  try
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg{argv[i]};
+      auto pos = arg.find('=');
+
+      if (arg.compare(0, 2, "--") != 0 || pos == std::string::npos)
+        throw std::runtime_error("Expected --key=value, got: " + arg);
+
+      auto key = arg.substr(2, pos - 2);
+      auto value = arg.substr(pos + 1);
+
+      if (key == "output")
+        output = value;
+      else if (key == "events")
+      {
+        shape.events = boost::lexical_cast<std::uint64_t>(value);
+        events_given = true;
+      }
+      else if (key == "bytes")
+        shape.bytes = boost::lexical_cast<std::uint64_t>(value);
+      else if (key == "streams")
+        shape.streams = boost::lexical_cast<std::uint32_t>(value);
+      else if (key == "packet-size")
+        shape.packet_size = boost::lexical_cast<std::uint32_t>(value);
+      else if (key == "processes")
+        shape.processes = boost::lexical_cast<std::uint32_t>(value);
+      else if (key == "events-per-second")
+        shape.events_per_second = boost::lexical_cast<std::uint64_t>(value);
+      else if (key == "seed")
+        shape.seed = boost::lexical_cast<std::uint64_t>(value);
+      else if (key == "mix")
+        shape.mix = boost::lexical_cast<ctf::generator::Mix>(value);
+      else if (key == "threads")
+        threads = boost::lexical_cast<unsigned int>(value);
+      else
+        throw std::runtime_error("Unknown option: " + key);
+    }
+
+    if (output.empty())
+      throw std::runtime_error("Missing --output");
+
+    // A size limit without an explicit event limit generates as many events as fit.
+    if (shape.bytes > 0 && not events_given)
+      shape.events = 0;
+
+    auto summary = ctf::generator::generate(output, shape, threads);
+
+    std::cout << summary.events << " events, " << summary.bytes << " bytes written to " << output.string() << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}